@@ -44,14 +44,10 @@ FAT12::FileInfo *FAT12::search(const char *name, FileInfo *finfo, int max) {
 void FAT12::loadFile(int clustno, int size, char *buf, char *img) {
 	for (;;) {
 		if (size <= 512) {
-			for (int i = 0; i < size; ++i) {
-				buf[i] = img[clustno  *512 + i];
-			}
+			memcpy(buf, img + clustno * 512, size);
 			break;
 		}
-		for (int i = 0; i < 512; ++i) {
-			buf[i] = img[clustno  *512 + i];
-		}
+		memcpy(buf, img + clustno * 512, 512);
 
 		size -= 512;
 		buf += 512;
@@ -59,14 +55,17 @@ void FAT12::loadFile(int clustno, int size, char *buf, char *img) {
 	}
 }
 
+// 末尾に '\0' を1つ足しておく (テキストファイルを文字列として読めるように)
 unsigned char *FAT12::loadFile2(int clustno, int &psize) {
-	unsigned char *buf = new unsigned char[psize];
+	unsigned char *buf = new unsigned char[psize + 1];
 	FAT12::loadFile(clustno, psize, (char *)buf, (char *)(ADDRESS_DISK_IMAGE + 0x003e00));
+	buf[psize] = 0;
 	if (psize >= 17) {
 		int tekSize = TekGetSize(buf);
 		if (tekSize > 0) {
-			unsigned char *buf2 = new unsigned char[tekSize];
+			unsigned char *buf2 = new unsigned char[tekSize + 1];
 			TekDecomp(buf, buf2, tekSize);
+			buf2[tekSize] = 0;
 			delete[] buf;
 			psize = tekSize;
 			return buf2;
@@ -74,3 +73,13 @@ unsigned char *FAT12::loadFile2(int clustno, int &psize) {
 	}
 	return buf;
 }
+
+// ディスクイメージの中のクラスタの先頭
+const char *FAT12::cluster(int clustno) {
+	return (const char *)(ADDRESS_DISK_IMAGE + 0x003e00) + clustno * 512;
+}
+
+// tek 圧縮されているか (ヘッダは先頭のクラスタに収まっている)
+bool FAT12::isCompressed(int clustno, int size) {
+	return size >= 17 && TekGetSize((unsigned char *)cluster(clustno)) > 0;
+}
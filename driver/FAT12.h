@@ -23,4 +23,24 @@ public:
 	static FileInfo *search(const char *name, FileInfo *finfo, int max);
 	static void loadFile(int clustno, int size, char *buf, char *img);
 	static unsigned char *loadFile2(int clustno, int &psize);
+	static const char *cluster(int clustno);
+	static bool isCompressed(int clustno, int size);
+
+	// ファイルの中身を，ディスクイメージの中で続いているクラスタごとにまとめて f(先頭, バイト数) に渡す (コピーはしない)
+	template <typename F>
+	static void eachRun(int clustno, int size, F &&f) {
+		while (size > 0) {
+			const char *start = cluster(clustno);
+			int length = 0;
+			for (;;) {
+				int n = size < 512 ? size : 512;
+				length += n;
+				size -= n;
+				if (size <= 0 || fat[clustno] != clustno + 1) break;
+				clustno = fat[clustno];
+			}
+			f(start, length);
+			clustno = fat[clustno];
+		}
+	}
 };
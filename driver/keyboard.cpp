@@ -66,20 +66,26 @@ void KeyboardController::Main() {
 	leds = (binfo->leds >> 4) & 7;
 	queue = task.queue;
 	
+	int codes[kKeyBurst];
 	for (;;) {
 		if (!cmd->isempty() && cmdWait < 0) {
 			cmdWait = cmd->pop();
 			wait();
 			Output8(kPortKeyData, cmdWait);
 		}
-		Cli();
-		if (queue->isempty()) {
-			task.sleep();
-			Sti();
+		// 届いている分をまとめて取り出す (割り込みは止めない)
+		int n = queue->pop_n(codes, kKeyBurst);
+		if (n) {
+			for (int i = 0; i < n; ++i) {
+				Decode(codes[i]);
+			}
 		} else {
-			unsigned char code = queue->pop();
+			// 眠るかどうかを決める間だけ割り込みを止める
+			Cli();
+			if (queue->isempty()) {
+				task.sleep();
+			}
 			Sti();
-			Decode(code);
 		}
 	}
 }
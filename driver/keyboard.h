@@ -13,6 +13,7 @@ const int kKeyStatusSendNotReady = 0x02;
 const int kKeyCmdWriteMode = 0x60;
 const int kKBCMode = 0x47;
 const int kKeyCmdLED = 0xed;
+const int kKeyBurst = 16; // 一度に取り出すスキャンコードの数
 
 class KeyboardController {
 private:
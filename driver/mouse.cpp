@@ -7,8 +7,6 @@ MouseDecode Mouse::mdec;
 
 void Mouse::Main() {
 	Task *task = TaskSwitcher::getNowTask();
-	unsigned char code;
-	int dx, dy;
 	
 	// メンバ初期化
 	mdec.pos = Point(SheetCtl::resolution.width / 2, SheetCtl::resolution.height / 2);
@@ -77,14 +75,16 @@ void Mouse::Main() {
 					break;
 			}
 		}
-		Cli();
-		if (queue->isempty()) {
-			task->sleep();
+		// 初期化の応答は 8 つ目で止めて後は Decode に任せるので，1つずつ取り出す (割り込みは止めない)
+		int data;
+		if (!queue->pop(data)) {
+			// 眠るかどうかを決める間だけ割り込みを止める
+			Cli();
+			if (queue->isempty()) {
+				task->sleep();
+			}
 			Sti();
 		} else {
-			int data = queue->pop();
-			Sti();
-			
 			if (0 <= i && i <= 6 && data == 0xfa) {
 				// 正常に ACK が来た
 			} else if (i == 7 && data == 0) {
@@ -114,78 +114,90 @@ void Mouse::Main() {
 	KeyboardController::wait();
 	Output8(kPortKeyData, kMouseCmdEnable);
 
+	int codes[kMouseBurst];
 	for (;;) {
-		Cli();
-		if (queue->isempty()) {
-			task->sleep();
-			Sti();
+		// 届いている分をまとめて取り出す (割り込みは止めない)
+		int n = queue->pop_n(codes, kMouseBurst);
+		if (n) {
+			for (int j = 0; j < n; ++j) {
+				Decode(codes[j]);
+			}
 		} else {
-			code = queue->pop();
-			Sti();
-			switch (mdec.phase) {
-				case 0:
-					if (code == 0xfa) ++mdec.phase;
-					break;
-				case 1:
-					if ((code & 0xc8) == 0x08) {
-						mdec.buf[0] = code;
-						++mdec.phase;
-					}
-					break;
-				case 2:
-					mdec.buf[1] = code;
-					++mdec.phase;
-					break;
-				case 3:
-					mdec.buf[2] = code;
-					
-					if (scroll) {
-						++mdec.phase;
-					} else {
-						mdec.phase = 1;
-					}
-					
-					mdec.btn = mdec.buf[0] & 0x07;
-					dx = mdec.buf[1];
-					dy = mdec.buf[2];
-					
-					if (mdec.buf[0] & 0x10) dx |= 0xffffff00;
-					if (mdec.buf[0] & 0x20) dy |= 0xffffff00;
-					mdec.pos = Point(
-						min(SheetCtl::resolution.width - 1, max(0, mdec.pos.x + dx)),
-						min(SheetCtl::resolution.height - 1, max(0, mdec.pos.y - dy))
-					);
-					
-					SheetCtl::mouseCursorPos = mdec.pos;
-					SheetCtl::queue->push(256);
-					
-					if (mdec.btn & 0x01) { // On left click
-						SheetCtl::queue->push(257);
-					}
-					if (mdec.btn & 0x02) { // On right click
-						SheetCtl::queue->push(258);
-					}
-					break;
-				case 4:
-					mdec.buf[3] = code;
-					mdec.phase = 1;
-					
-					// mdec.buf[3]は、下位4ビットだけが有効な値である
-					// とりあえず解析せずに値をしまう。
-					mdec.scroll = mdec.buf[3] & 0x0f;
-					if (mdec.scroll & 0x08) {
-						// マイナスの値だった
-						mdec.scroll |= 0xfffffff0;
-					}
-					
-					if (mdec.scroll == -1) {
-						SheetCtl::queue->push(259);
-					} else if (mdec.scroll == 1) {
-						SheetCtl::queue->push(260);
-					}
-					
-					break;
+			// 眠るかどうかを決める間だけ割り込みを止める
+			Cli();
+			if (queue->isempty()) {
+				task->sleep();
 			}
+			Sti();
 		}
 	}
 }
+
+void Mouse::Decode(unsigned char code) {
+	int dx, dy;
+	
+	switch (mdec.phase) {
+		case 0:
+			if (code == 0xfa) ++mdec.phase;
+			break;
+		case 1:
+			if ((code & 0xc8) == 0x08) {
+				mdec.buf[0] = code;
+				++mdec.phase;
+			}
+			break;
+		case 2:
+			mdec.buf[1] = code;
+			++mdec.phase;
+			break;
+		case 3:
+			mdec.buf[2] = code;
+			
+			if (scroll) {
+				++mdec.phase;
+			} else {
+				mdec.phase = 1;
+			}
+			
+			mdec.btn = mdec.buf[0] & 0x07;
+			dx = mdec.buf[1];
+			dy = mdec.buf[2];
+			
+			if (mdec.buf[0] & 0x10) dx |= 0xffffff00;
+			if (mdec.buf[0] & 0x20) dy |= 0xffffff00;
+			mdec.pos = Point(
+				min(SheetCtl::resolution.width - 1, max(0, mdec.pos.x + dx)),
+				min(SheetCtl::resolution.height - 1, max(0, mdec.pos.y - dy))
+			);
+			
+			SheetCtl::mouseCursorPos = mdec.pos;
+			SheetCtl::queue->push(256);
+			
+			if (mdec.btn & 0x01) { // On left click
+				SheetCtl::queue->push(257);
+			}
+			if (mdec.btn & 0x02) { // On right click
+				SheetCtl::queue->push(258);
+			}
+			break;
+		case 4:
+			mdec.buf[3] = code;
+			mdec.phase = 1;
+			
+			// mdec.buf[3]は、下位4ビットだけが有効な値である
+			// とりあえず解析せずに値をしまう。
+			mdec.scroll = mdec.buf[3] & 0x0f;
+			if (mdec.scroll & 0x08) {
+				// マイナスの値だった
+				mdec.scroll |= 0xfffffff0;
+			}
+			
+			if (mdec.scroll == -1) {
+				SheetCtl::queue->push(259);
+			} else if (mdec.scroll == 1) {
+				SheetCtl::queue->push(260);
+			}
+			
+			break;
+	}
+}
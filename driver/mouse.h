@@ -6,6 +6,7 @@
 
 const int kKeyCmdSendToMouse = 0xd4;
 const int kMouseCmdEnable = 0xf4;
+const int kMouseBurst = 32; // 一度に取り出すデータの数
 
 //class Browser;
 
@@ -23,6 +24,8 @@ private:
 	static bool scroll;
 	static TaskQueue *queue;
 	//static Task *browserTask;
+	
+	static void Decode(unsigned char code);
 
 public:
 	friend void IntHandler2c(int *esp);
@@ -27,14 +27,16 @@ void Beep(char c, int len, Timer *timer, bool st) {
 	}
 	Output8(0x61, i);
 
+	// 自分のタイマーが来たところで戻るので，1つずつ取り出す (割り込みは止めない)
 	for (;;) {
-		Cli();
-		if (!timer->queue->isempty()) {
-			i = timer->queue->pop();
-			Sti();
+		if (timer->queue->pop(i)) {
 			if (i == timer->data) return;
 		} else {
-			TaskSwitcher::getNowTask()->sleep();
+			// 眠るかどうかを決める間だけ割り込みを止める
+			Cli();
+			if (timer->queue->isempty()) {
+				TaskSwitcher::getNowTask()->sleep();
+			}
 			Sti();
 		}
 	}
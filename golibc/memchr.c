@@ -6,18 +6,35 @@
 #include <stdio.h>
 #include <stddef.h>
 
+// a 32-bit word that may alias any other type
+typedef unsigned int __attribute__((__may_alias__)) word;
+
+// nonzero if some byte of X is 0
+#define HAS_ZERO(x) (((x) - 0x01010101u) & ~(x) & 0x80808080u)
+
 //=============================================================================
 // search SZ bytes of D for C
+//   * tests 4 bytes at a time once D is aligned
 //=============================================================================
-void* memchr (void *d, int c, size_t sz)
+void* memchr (const void *d, int c, size_t sz)
 {
-	char *dp = (char*)d;
+	const unsigned char *dp = (const unsigned char*)d;
+	unsigned char ch = (unsigned char)c;
+	unsigned int mask = ch * 0x01010101u;
 
-	while (sz--) {
-		if (c == *dp)
-			return dp;
-		++dp;
+	for (; sz && ((size_t)dp & 3); --sz, ++dp)
+		if (ch == *dp)
+			return (void*)dp;
+
+	for (; sz >= 4; sz -= 4, dp += 4) {
+		unsigned int x = *(const word*)dp ^ mask;
+		if (HAS_ZERO(x))
+			break;
 	}
 
+	for (; sz; --sz, ++dp)
+		if (ch == *dp)
+			return (void*)dp;
+
 	return NULL;
 }
@@ -5,14 +5,23 @@
 
 #include <stddef.h>
 
+// a 32-bit word that may alias any other type
+typedef unsigned int __attribute__((__may_alias__)) word;
+
 //=============================================================================
 // compare SZ bytes of D and S
+//   * skips equal 4-byte words, then finds the differing byte
 //=============================================================================
 int memcmp (const void *d, const void *s, size_t sz)
 {
-	const char *dp = (const char*) d;
-	const char *sp = (const char*) s;
+	const unsigned char *dp = (const unsigned char*) d;
+	const unsigned char *sp = (const unsigned char*) s;
 
+	while (sz >= 4 && *(const word*)dp == *(const word*)sp) {
+		dp += 4;
+		sp += 4;
+		sz -= 4;
+	}
 	while (sz--) {
 		if (*dp != *sp)
 			return *dp - *sp;
@@ -5,15 +5,36 @@
 
 #include <stddef.h>
 
+// a 32-bit word that may alias any other type
+typedef unsigned int __attribute__((__may_alias__)) word;
+
 //=============================================================================
 // copy SZ bytes of S to D
+//   * short copies move 4 bytes at a time in a loop (rep has a start-up cost)
+//   * long copies align D and use rep movsl
+//   * always copies forward (memmove relies on this when D < S)
 //=============================================================================
-void* memcpy (void *d, void *s, size_t sz)
+__attribute__((optimize("no-tree-loop-distribute-patterns")))
+void* memcpy (void *d, const void *s, size_t sz)
 {
 	void *tmp = d;
-	char *dp = (char*)d;
-	char *sp = (char*)s;
+	char *dp;
+	const char *sp;
+	size_t n;
+
+	if (sz >= 64) {
+		n = -(size_t)d & 3;
+		sz -= n;
+		__asm__ volatile ("rep movsb" : "+D"(d), "+S"(s), "+c"(n) : : "memory");
+		n = sz >> 2;
+		sz &= 3;
+		__asm__ volatile ("rep movsl" : "+D"(d), "+S"(s), "+c"(n) : : "memory");
+	}
 
+	dp = (char*)d;
+	sp = (const char*)s;
+	for (; sz >= 4; sz -= 4, dp += 4, sp += 4)
+		*(word*)dp = *(const word*)sp;
 	while (sz--)
 		*dp++ = *sp++;
 
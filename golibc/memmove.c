@@ -4,26 +4,35 @@
 //*****************************************************************************
 
 #include <stddef.h>
+#include <string.h>
+
+// a 32-bit word that may alias any other type
+typedef unsigned int __attribute__((__may_alias__)) word;
 
 //=============================================================================
 // copy SZ bytes of S to D
 //   * guarantee - acceptable result for overlaped strings
 //=============================================================================
-void* memmove (void *d, void *s, size_t sz)
+__attribute__((optimize("no-tree-loop-distribute-patterns")))
+void* memmove (void *d, const void *s, size_t sz)
 {
-	void *tmp = d;
-	char *dp = (char*)d;
-	char *sp = (char*)s;
+	char *dp;
+	const char *sp;
+
+	// D is below S, or the areas do not overlap: a forward copy is safe
+	if ((size_t)((char*)d - (const char*)s) >= sz)
+		return memcpy(d, s, sz);
 
-	if (dp > sp) {
-		dp += sz;
-		sp += sz;
-		while (sz--)
-			*--dp = *--sp;
-	} else {
-		while (sz--)
-			*dp++ = *sp++;
+	// copy backward 4 bytes at a time (std + rep movs is very slow on recent CPUs)
+	dp = (char*)d + sz;
+	sp = (const char*)s + sz;
+	for (; sz >= 4; sz -= 4) {
+		dp -= 4;
+		sp -= 4;
+		*(word*)dp = *(const word*)sp;
 	}
+	while (sz--)
+		*--dp = *--sp;
 
-	return tmp;
+	return d;
 }
@@ -5,14 +5,34 @@
 
 #include <stddef.h>
 
+// a 32-bit word that may alias any other type
+typedef unsigned int __attribute__((__may_alias__)) word;
+
 //=============================================================================
 // set SZ bytes of S to C
+//   * short fills store 4 bytes at a time in a loop (rep has a start-up cost)
+//   * long fills align D and use rep stosl
 //=============================================================================
+__attribute__((optimize("no-tree-loop-distribute-patterns")))
 void * memset (void *d, int c, size_t sz)
 {
 	void *tmp = d;
-	char *dp = (char*)d;
+	unsigned int v = (unsigned char)c * 0x01010101u;
+	char *dp;
+	size_t n;
+
+	if (sz >= 64) {
+		n = -(size_t)d & 3;
+		sz -= n;
+		__asm__ volatile ("rep stosb" : "+D"(d), "+c"(n) : "a"(v) : "memory");
+		n = sz >> 2;
+		sz &= 3;
+		__asm__ volatile ("rep stosl" : "+D"(d), "+c"(n) : "a"(v) : "memory");
+	}
 
+	dp = (char*)d;
+	for (; sz >= 4; sz -= 4, dp += 4)
+		*(word*)dp = v;
 	while (sz--)
 		*dp++ = c;
 
@@ -0,0 +1,25 @@
+//*****************************************************************************
+// memset32.c : memory function
+//*****************************************************************************
+
+#include <stddef.h>
+
+//=============================================================================
+// set N 32-bit words of D to V (for filling pixels)
+//   * rep stosl only pays off for longer runs
+//=============================================================================
+__attribute__((optimize("no-tree-loop-distribute-patterns")))
+void * memset32 (void *d, unsigned int v, size_t n)
+{
+	void *tmp = d;
+	unsigned int *dp = (unsigned int*)d;
+
+	if (n >= 16) {
+		__asm__ volatile ("rep stosl" : "+D"(d), "+c"(n) : "a"(v) : "memory");
+		return tmp;
+	}
+	while (n--)
+		*dp++ = v;
+
+	return tmp;
+}
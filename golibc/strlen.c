@@ -5,15 +5,30 @@
 
 #include <stddef.h>
 
+// a 32-bit word that may alias any other type
+typedef unsigned int __attribute__((__may_alias__)) word;
+
+// nonzero if some byte of X is 0
+#define HAS_ZERO(x) (((x) - 0x01010101u) & ~(x) & 0x80808080u)
+
 //=============================================================================
 // return the length of D
+//   * reads aligned 4-byte words, which never cross a page boundary
 //=============================================================================
-size_t strlen (char *d)
+size_t strlen (const char *d)
 {
-	char *tmp = d;
+	const char *tmp = d;
+	const word *w;
+
+	for (; (size_t)d & 3; d++)
+		if ('\0' == *d)
+			return d - tmp;
+
+	for (w = (const word*)d; !HAS_ZERO(*w); w++)
+		;
 
-	while ('\0' != *d)
-		d++;
+	for (d = (const char*)w; '\0' != *d; d++)
+		;
 
 	return d - tmp;
 }
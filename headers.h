@@ -6,6 +6,9 @@
 #include "kernel/jpeg.h"
 //#include "kernel/language.h"
 #include "kernel/memory.h"
+#include "kernel/paging.h"
+#include "kernel/heapprof.h"
+#include "kernel/benchmark.h"
 #include "kernel/multitask.h"
 #include "kernel/sysinfo.h"
 #include "kernel/tek.h"
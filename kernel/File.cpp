@@ -1,8 +1,12 @@
 #include "../headers.h"
 
-bool File::open() {
+FAT12::FileInfo *File::find() {
 	// FAT12
-	FAT12::FileInfo *info = FAT12::search(_name.c_str(), (FAT12::FileInfo *)(ADDRESS_DISK_IMAGE + 0x002600), 224);
+	return FAT12::search(_name.c_str(), (FAT12::FileInfo *)(ADDRESS_DISK_IMAGE + 0x002600), 224);
+}
+
+bool File::open() {
+	FAT12::FileInfo *info = find();
 	if (info) {
 		_size = info->size;
 		buf.reset(FAT12::loadFile2(info->clustno, _size));
@@ -1,13 +1,17 @@
 #pragma once
 
 #include <SmartPointer.h>
+#include <StringView.h>
 #include <pistring.h>
+#include "../driver/FAT12.h"
 
 class File {
 private:
 	string _name;
 	shared_ptr<unsigned char> buf;
 	int _size;
+	
+	FAT12::FileInfo *find();
 
 public:
 	const string &name = _name;
@@ -19,5 +23,21 @@ public:
 	bool open(const string &fileName);
 	inline const shared_ptr<unsigned char> &read() {
 		return buf;
+	}	
+	// 中身を読めた分ずつ f(string_view) に渡す (無ければ false)．
+	// 圧縮されていなければディスクイメージのクラスタを指したまま渡すので，全部を読み終える前から使える．
+	// tek 圧縮されていれば展開してから1回で渡す (渡した中身は File を残しておく間だけ使える)
+	template <typename F>
+	bool readChunks(F &&f) {
+		FAT12::FileInfo *info = find();
+		if (!info) return false;
+		_size = info->size;
+		if (FAT12::isCompressed(info->clustno, _size)) {
+			buf.reset(FAT12::loadFile2(info->clustno, _size));
+			f(string_view(reinterpret_cast<const char *>(buf.get()), _size));
+		} else {
+			FAT12::eachRun(info->clustno, _size, [&](const char *p, int n) { f(string_view(p, n)); });
+		}
+		return true;
 	}
 };
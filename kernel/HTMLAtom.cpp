@@ -0,0 +1,127 @@
+#include <string.h>
+#include <KeywordTable.h>
+#include "HTMLAtom.h"
+
+using namespace HTML;
+
+namespace {
+	constexpr const char *kAtomNames[] = {
+		// Tag と同じ順
+		"a", "address", "applet", "area", "article", "aside",
+		"b", "base", "basefont", "bgsound", "big", "blockquote", "body", "br", "button",
+		"caption", "center", "code", "col", "colgroup",
+		"dd", "details", "dialog", "dir", "div", "dl", "dt",
+		"em", "embed",
+		"fieldset", "figcaption", "figure", "font", "footer", "form", "frame", "frameset",
+		"h1", "h2", "h3", "h4", "h5", "h6", "head", "header", "hgroup", "hr", "html",
+		"i", "iframe", "image", "img", "input", "isindex",
+		"keygen",
+		"li", "link", "listing",
+		"main", "marquee", "math", "menu", "menuitem", "meta",
+		"nav", "nobr", "noembed", "noframes", "noscript",
+		"object", "ol", "optgroup", "option",
+		"p", "param", "plaintext", "pre",
+		"rp", "rt",
+		"s", "sarcasm", "script", "section", "select", "small", "source", "strike", "strong", "style", "summary", "svg",
+		"table", "tbody", "td", "template", "textarea", "tfoot", "th", "thead", "title", "tr", "track", "tt",
+		"u", "ul",
+		"wbr",
+		"xmp",
+
+		// 木の構築では区別しない要素名
+		"abbr", "acronym", "audio", "bdi", "bdo", "blink", "canvas", "cite", "data", "datalist", "del", "dfn",
+		"ins", "kbd", "label", "legend", "map", "mark", "meter", "multicol", "nextid", "output", "picture", "progress",
+		"q", "rb", "rtc", "ruby", "samp", "search", "slot", "spacer", "span", "sub", "sup", "time", "var", "video",
+
+		// 属性名 (要素名と同じ名前は上にあるので除く)
+		"accept", "accept-charset", "accesskey", "action", "align", "alink", "allow", "allowfullscreen", "alt",
+		"archive", "async", "autocapitalize", "autocomplete", "autofocus", "autoplay", "axis",
+		"background", "bgcolor", "border",
+		"cellpadding", "cellspacing", "char", "charoff", "charset", "checked", "class", "classid", "clear",
+		"codebase", "codetype", "color", "cols", "colspan", "compact", "content", "contenteditable", "controls",
+		"coords", "crossorigin",
+		"datetime", "declare", "decoding", "default", "defer", "dirname", "disabled", "download", "draggable",
+		"enctype", "enterkeyhint",
+		"face", "for", "formaction", "formenctype", "formmethod", "formnovalidate", "formtarget", "frameborder",
+		"headers", "height", "hidden", "high", "href", "hreflang", "hspace", "http-equiv",
+		"id", "inert", "inputmode", "integrity", "is", "ismap", "itemid", "itemprop", "itemref", "itemscope", "itemtype",
+		"kind",
+		"lang", "language", "list", "loading", "longdesc", "loop", "low",
+		"manifest", "marginheight", "marginwidth", "max", "maxlength", "media", "method", "min", "minlength",
+		"multiple", "muted",
+		"name", "nohref", "nomodule", "nonce", "noresize", "noshade", "novalidate", "nowrap",
+		"onabort", "onblur", "onchange", "onclick", "ondblclick", "onerror", "onfocus", "oninput", "onkeydown",
+		"onkeypress", "onkeyup", "onload", "onmousedown", "onmousemove", "onmouseout", "onmouseover", "onmouseup",
+		"onreset", "onresize", "onscroll", "onselect", "onsubmit", "onunload", "open", "optimum",
+		"pattern", "ping", "placeholder", "popover", "poster", "preload", "profile",
+		"readonly", "referrerpolicy", "rel", "required", "rev", "reversed", "rows", "rowspan", "rules",
+		"sandbox", "scope", "scrolling", "selected", "shape", "size", "sizes", "spellcheck", "src", "srcdoc",
+		"srclang", "srcset", "standby", "start", "step",
+		"tabindex", "target", "text", "translate", "type",
+		"usemap",
+		"valign", "value", "valuetype", "version", "vlink", "vspace",
+		"width", "wrap",
+		"xmlns",
+	};
+	constexpr int kAtomCount = sizeof(kAtomNames) / sizeof(kAtomNames[0]);
+
+	constexpr KeywordTable<kAtomCount> kAtomTable(kAtomNames);
+	static_assert(kAtomTable.ok(), "atom names must not collide");
+
+	// 先頭が Tag と同じ並びか (どちらかに足すときは両方の同じ位置に)
+	constexpr bool sameAtom(const char *name, Tag tag) {
+		return kAtomTable.find(name) + 1 == static_cast<int>(tag);
+	}
+	static_assert(sameAtom("a", Tag::A) && sameAtom("h1", Tag::H1) && sameAtom("html", Tag::Html) &&
+		sameAtom("p", Tag::P) && sameAtom("table", Tag::Table) && sameAtom("xmp", Tag::Xmp),
+		"kAtomNames must start with the Tag names in Tag order");
+	static_assert(kAtomTable.find("abbr") == static_cast<int>(Tag::Xmp), "Tag names must be followed by the other names");
+
+	// Tag はアルファベット順なので，先頭の名前も同じ順に並んでいれば入れ替わりも見つかる
+	constexpr bool tagNamesSorted() {
+		for (int i = 1; i < static_cast<int>(Tag::Xmp); ++i) {
+			string_view a = kAtomNames[i - 1], b = kAtomNames[i];
+			unsigned int k = 0;
+			while (k < a.length() && k < b.length() && a[k] == b[k]) ++k;
+			if (k == b.length() || (k < a.length() && a[k] > b[k])) return false;
+		}
+		return true;
+	}
+	static_assert(tagNamesSorted(), "Tag names in kAtomNames must stay in alphabetical (Tag) order");
+
+}
+
+Atom HTML::AtomOf(string_view name) {
+	return kAtomTable.find(name) + 1;
+}
+
+string_view HTML::AtomName(Atom atom) {
+	if (atom == 0 || atom > kAtomCount) return string_view();
+	return kAtomNames[atom - 1];
+}
+
+// AtomTable
+AtomTable::~AtomTable() {
+	for (string_view name : names) {
+		delete[] name.data();
+	}
+}
+
+Atom AtomTable::atomOf(string_view name) {
+	if (Atom atom = AtomOf(name)) return atom;
+	if (name.empty()) return 0;
+
+	if (const Atom *atom = atoms.find(name)) return *atom;
+	if (names.size() >= kMaxNames) return 0; // もう足さない
+	char *copy = new char[name.length()];
+	memcpy(copy, name.data(), name.length());
+	Atom atom = kAtomCount + 1 + names.size();
+	names.push_back(string_view(copy, name.length()));
+	atoms.insert(names.back(), atom);
+	return atom;
+}
+
+string_view AtomTable::nameOf(Atom atom) const {
+	if (atom <= kAtomCount) return AtomName(atom);
+	return names[atom - kAtomCount - 1];
+}
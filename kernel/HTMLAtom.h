@@ -0,0 +1,55 @@
+#pragma once
+
+#include <StringView.h>
+#include <Vector.h>
+#include <HashMap.h>
+#include "HTMLTag.h"
+
+namespace HTML {
+	/*
+	 * タグ名・属性名を小さな整数にしたもの (同じ名前なら同じ値なので，名前を比べる代わりに == で比べられる)．
+	 * 0 は名前なし．HTML の要素名と属性名は HTMLAtom.cpp の kAtomNames でコンパイル時に決めてあり，
+	 * 先頭は Tag と同じ並びなので Tag の値がそのまま Atom になる．表に無い名前は文書ごとの AtomTable で後ろに足していく．
+	 */
+	typedef unsigned short Atom;
+
+	// ここまでの Atom は Tag と同じ値
+	constexpr Atom kLastTagAtom = static_cast<Atom>(Tag::Xmp);
+
+	// 名前 (小文字) の Atom (表に無ければ 0)
+	Atom AtomOf(string_view name);
+	// 表にある Atom の名前 (0 や表に無い Atom なら "")
+	string_view AtomName(Atom atom);
+
+	/*
+	 * 表に無い名前にも Atom を振る表．Document が1つずつ持ち，名前の写しも Document と一緒に放す
+	 * (タブのタスクの Arena から取るので，タスクをまたいで共有しない)．
+	 * 同じ文書の中でだけ同じ名前が同じ Atom になる．
+	 */
+	class AtomTable {
+	private:
+		Vector<string_view> names; // 表に無かった名前 (Atom は kAtomNames の後ろから順に振る)
+		HashMap<string_view, Atom> atoms;
+
+	public:
+		// 1つの文書で足せる名前の数 (超えた名前は 0)
+		static const int kMaxNames = 1024;
+
+		AtomTable() {}
+		AtomTable(const AtomTable &) = delete;
+		AtomTable &operator=(const AtomTable &) = delete;
+		~AtomTable();
+		// 名前 (小文字) の Atom．表に無ければ足す
+		Atom atomOf(string_view name);
+		// Atom の名前 (0 なら "")
+		string_view nameOf(Atom atom) const;
+	};
+
+	inline Atom AtomOf(Tag tag) {
+		return static_cast<Atom>(tag);
+	}
+	// Atom が Tag の名前ならその Tag (そうでなければ Tag::Unknown)
+	inline Tag TagOf(Atom atom) {
+		return atom <= kLastTagAtom ? static_cast<Tag>(atom) : Tag::Unknown;
+	}
+}
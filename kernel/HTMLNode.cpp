@@ -1,12 +1,18 @@
+#include <string.h>
 #include "HTMLNode.h"
 
 using namespace HTML;
 
 // Node
-const shared_ptr<Node> &Node::appendChild(const shared_ptr<Node> &node) {
+const intrusive_ptr<Node> &Node::appendChild(const intrusive_ptr<Node> &node) {
 	children.push_back(node);
 	return node;
 }
 
 // Element
-Element::Element(const string &name) : _tagName(name) {}
+Element::Element(Atom atom, string_view name) : _tagName(atom), name(name) {}
+
+// TextNode
+void TextNode::appendData(string_view data) {
+	memcpy(wholeText.extend(data.length()), data.data(), data.length());
+}
@@ -1,34 +1,40 @@
 #pragma once
 
-#include <List.h>
+#include <Vector.h>
 #include <SmartPointer.h>
 #include <pistring.h>
+#include "HTMLAtom.h"
 
 namespace HTML {
-	class Node {
+	class Node : public RefCounted {
 	public:
-		List<shared_ptr<Node>> children;
+		Vector<intrusive_ptr<Node>> children;
 		
 		virtual ~Node() {}
 		virtual string getData() {
 			return "";
 		}
-		const shared_ptr<Node> &appendChild(const shared_ptr<Node> &node);
+		const intrusive_ptr<Node> &appendChild(const intrusive_ptr<Node> &node);
 	};
 	
 	class Element : public Node {
 	private:
-		string _tagName;
+		Atom _tagName;
+		string_view name; // タグ名 (表に無い名前は Document の AtomTable が持っている)
 		string id;
 		string className;
 	
 	public:
-		//const string &tagName = _tagName;
-	
 		//Element() {}
-		Element(const string &name);
+		Element(Atom atom, string_view name);
+		Atom tagName() const {
+			return _tagName;
+		}
+		Tag tag() const {
+			return TagOf(_tagName);
+		}
 		string getData() {
-			return "<" + _tagName + ">";
+			return "<" + string(name) + ">";
 		}
 	};
 	
@@ -37,6 +43,7 @@ namespace HTML {
 		string wholeText;
 		
 		TextNode(string str) : wholeText(str) {}
+		void appendData(string_view data);
 		string getData() {
 			return wholeText;
 		}
@@ -48,7 +55,7 @@ namespace HTML {
 		string publicId = "";
 		string systemId = "";
 		
-		explicit DocumentType(const string &n) : name(n) {}
+		explicit DocumentType(string_view n) : name(n) {}
 		DocumentType(const string &n, const string &p, const string &s) : name(n), publicId(p), systemId(s) {}
 		string getData() {
 			return "<!doctype " + name + ">";
@@ -68,6 +75,7 @@ namespace HTML {
 	public:
 		//DocumentType doctype;
 		//Element documentElement;
+		AtomTable atoms; // この文書のタグ名・属性名の Atom
 		
 		string getData() {
 			return "Document ノード";
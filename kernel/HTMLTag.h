@@ -0,0 +1,28 @@
+#pragma once
+
+namespace HTML {
+	// 木の構築で区別するタグ名 (HTMLAtom.cpp の kAtomNames の先頭と同じ順)
+	enum class Tag : unsigned char {
+		Unknown,
+		A, Address, Applet, Area, Article, Aside,
+		B, Base, Basefont, Bgsound, Big, Blockquote, Body, Br, Button,
+		Caption, Center, Code, Col, Colgroup,
+		Dd, Details, Dialog, Dir, Div, Dl, Dt,
+		Em, Embed,
+		Fieldset, Figcaption, Figure, Font, Footer, Form, Frame, Frameset,
+		H1, H2, H3, H4, H5, H6, Head, Header, Hgroup, Hr, Html,
+		I, Iframe, Image, Img, Input, Isindex,
+		Keygen,
+		Li, Link, Listing,
+		Main, Marquee, Math, Menu, Menuitem, Meta,
+		Nav, Nobr, Noembed, Noframes, Noscript,
+		Object, Ol, Optgroup, Option,
+		P, Param, Plaintext, Pre,
+		Rp, Rt,
+		S, Sarcasm, Script, Section, Select, Small, Source, Strike, Strong, Style, Summary, Svg,
+		Table, Tbody, Td, Template, Textarea, Tfoot, Th, Thead, Title, Tr, Track, Tt,
+		U, Ul,
+		Wbr,
+		Xmp,
+	};
+}
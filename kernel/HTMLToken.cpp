@@ -2,7 +2,7 @@
 
 using namespace HTML;
 
-Token::Attribute::Attribute(string _name, string _value) : name(_name), value(_value) {}
+ObjectPool<Token> Token::pool("HTML::Token");
 
 Token::Token(Type tokenType) : type(tokenType) {}
 
@@ -14,14 +14,30 @@ bool Token::isSelfClosing() {
 	return selfClosingFlag;
 }
 
+void Token::appendAttribute(const char *p) {
+	attributes.emplace_back().name.append(p);
+}
+
 void Token::appendAttribute(char c) {
-	attributes.push_back(shared_ptr<Attribute>(new Attribute(string(1, c), "")));
+	attributes.emplace_back().name += c;
+}
+
+void Token::appendAttributeName(const char *p) {
+	attributes.back().name.append(p);
 }
 
 void Token::appendAttributeName(char c) {
-	attributes.back()->name += c;
+	attributes.back().name += c;
+}
+
+void Token::appendAttributeValue(const char *p) {
+	attributes.back().value.append(p);
 }
 
-void Token::appendAttributeValue(char c) {
-	attributes.back()->value += c;
+// タグ名と属性名を Atom にする
+void Token::internNames(AtomTable &table) {
+	tagName = table.atomOf(data);
+	for (auto &&attribute : attributes) {
+		attribute.atom = table.atomOf(attribute.name);
+	}
 }
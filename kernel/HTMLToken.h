@@ -1,21 +1,74 @@
 #pragma once
 
-#include <List.h>
+#include <string.h>
+#include <Vector.h>
 #include <pistring.h>
+#include <StringView.h>
 #include <SmartPointer.h>
+#include <ObjectPool.h>
+#include "HTMLAtom.h"
 
 namespace HTML {
-	class Token {
+	// トークンの文字列．ソースの文字をそのまま使う間はソースの一部を指すだけで，
+	// 書き換えたとき (大文字の変換や文字参照など) に初めて自分の string にコピーする
+	class SourceString {
+	private:
+		string_view view;
+		string owned;
+		bool isOwned = false;
+		
+		void own() {
+			if (!isOwned) {
+				owned = string(view);
+				isOwned = true;
+			}
+		}
+	
+	public:
+		// ソースの p から n 文字を足す (直前の文字の続きなら view を伸ばすだけ)
+		void append(const char *p, unsigned n = 1) {
+			if (!isOwned) {
+				if (view.empty()) {
+					view = string_view(p, n);
+					return;
+				} else if (view.end() == p) {
+					view = string_view(view.data(), view.length() + n);
+					return;
+				}
+			}
+			own();
+			memcpy(owned.extend(n), p, n);
+		}
+		// ソースに無い文字を足す
+		SourceString &operator+=(char c) {
+			own();
+			owned += c;
+			return *this;
+		}
+		SourceString &operator+=(const char *str) {
+			own();
+			owned += str;
+			return *this;
+		}
+		operator string_view() const {
+			if (isOwned) return owned;
+			return view;
+		}
+		bool owning() const {
+			return isOwned;
+		}
+	};
+	
+	class Token : public RefCounted {
 	private:
 		// for StartTag and EndTag
 		struct Attribute {
-			string name;
-			string value;
-			
-			Attribute(string _name, string _value);
+			SourceString name;
+			SourceString value;
+			Atom atom = 0; // name の Atom
 		};
 		bool selfClosingFlag = false;
-		List<shared_ptr<Attribute>> attributes;
+		Vector<Attribute> attributes;
 	
 	public:
 		// for all types
@@ -23,16 +76,25 @@ namespace HTML {
 			Character, StartTag, EndTag, DOCTYPE, Comment, EndOfFile
 		};
 		const Type type;
-		string data;
+		SourceString data; // ソースを指しているので，ソースより長く使わないこと
+		Atom tagName = 0;  // for StartTag and EndTag (data の Atom．木の構築で使う前に internNames() で決める)
 		
 		// for all types
 		explicit Token(Type tokenType);
 		
 		// for StartTag and EndTag
+		// (const char * はソースの文字，char は書き換えた文字)
 		void setSelfClosingFlag();
 		bool isSelfClosing();
+		void appendAttribute(const char *p);
 		void appendAttribute(char c);
+		void appendAttributeName(const char *p);
 		void appendAttributeName(char c);
-		void appendAttributeValue(char c);
+		void appendAttributeValue(const char *p);
+		void internNames(AtomTable &table);
+		
+		static ObjectPool<Token> pool;
+		static void *operator new(long unsigned int) { return pool.alloc(); }
+		static void operator delete(void *p) { pool.free(p); }
 	};
 }
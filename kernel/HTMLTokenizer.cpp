@@ -73,19 +73,118 @@ enum class Tokenizer::State {
 	CDATASection
 };
 
-Tokenizer::Tokenizer() : tokens(128) {}
+// ソースの文字 *p を小文字にして足す (大文字のときだけ書き換えになる)
+static inline void appendLower(SourceString &str, const char *p) {
+	if ('A' <= *p && *p <= 'Z') {
+		str += (char)(*p + 0x20);
+	} else {
+		str.append(p);
+	}
+}
 
-Queue<shared_ptr<Token>> &Tokenizer::tokenize(const string &inputStream) {
-	State state = State::Data; // Data state
-	unique_ptr<Token> token;
+// 4バイトずつまとめて読む
+typedef unsigned int __attribute__((__may_alias__)) word;
 
-	auto it = inputStream.begin();
-	int i = 0;
-	bool endFlag = false;
-	while (!endFlag) {
+// c が Cs のどれかか
+template <unsigned char ...Cs>
+static inline bool isAnyOf(unsigned char c) {
+	bool match = false;
+	bool expand[] = { (match |= c == Cs)... };
+	(void)expand;
+	return match;
+}
+
+// w のどこかのバイトが Cs のどれかなら 0 以外 (そのバイトと xor すると 0 になるのを，ゼロバイト検出で調べる)
+template <unsigned char ...Cs>
+static inline word matchAny(word w) {
+	word match = 0;
+	word expand[] = { (match |= ((w ^ Cs * 0x01010101u) - 0x01010101u) & ~(w ^ Cs * 0x01010101u) & 0x80808080u)... };
+	(void)expand;
+	return match;
+}
+
+// [p, e) で最初に Cs のどれかが現れる位置 (無ければ e)
+template <unsigned char ...Cs>
+static const char *findAny(const char *p, const char *e) {
+	for (; p < e && ((size_t)p & 3); ++p) {
+		if (isAnyOf<Cs...>(*p)) return p;
+	}
+	for (; e - p >= 4 && !matchAny<Cs...>(*(const word *)p); p += 4) {}
+	for (; p < e; ++p) {
+		if (isAnyOf<Cs...>(*p)) return p;
+	}
+	return e;
+}
+
+Tokenizer::Tokenizer() : state(State::Data), tokens(4) {}
+
+void Tokenizer::feed(string_view input) {
+	if (input.empty()) return;
+	if (it == end && rest.empty()) {
+		it = input.begin();
+		end = input.end();
+	} else {
+		rest.push_back(input);
+	}
+}
+
+void Tokenizer::finish() {
+	finished = true;
+}
+
+intrusive_ptr<Token> Tokenizer::next() {
+	if (tokens.isempty()) run();
+	if (tokens.isempty()) return intrusive_ptr<Token>();
+	return tokens.pop();
+}
+
+// 次の入力に進む (今の入力を読み終えたら，次に渡された入力へ)
+void Tokenizer::advance() {
+	if (++it == end && restHead < rest.size()) {
+		it = rest[restHead].begin();
+		end = rest[restHead].end();
+		if (++restHead == rest.size()) {
+			rest.clear();
+			restHead = 0;
+		}
+	}
+}
+
+void Tokenizer::skip(int n) {
+	for (int i = 0; i < n; ++i) advance();
+}
+
+// 今の位置から n 文字が word と同じか (1: 同じ，0: 違う，-1: 入力がまだ届いていないので分からない)
+int Tokenizer::lookahead(const char *word, int n, bool ignoreCase) const {
+	const char *p = it, *e = end;
+	int k = restHead;
+	for (int i = 0; i < n; ++i) {
+		while (p == e) {
+			if (k == rest.size()) return finished ? 0 : -1;
+			p = rest[k].begin();
+			e = rest[k].end();
+			++k;
+		}
+		char c = *p++, d = word[i];
+		if (ignoreCase && 'A' <= c && c <= 'Z') c += 'a' - 'A';
+		if (ignoreCase && 'A' <= d && d <= 'Z') d += 'a' - 'A';
+		if (c != d) return 0;
+	}
+	return 1;
+}
+
+// トークンが出るか，入力が足りなくなるまで進める
+void Tokenizer::run() {
+	while (tokens.isempty() && !endFlag) {
+		// 入力の終わりは，finish() の後でなければ EOF ではなく続きを待つ (それまでの文字は先に渡す)
+		if (it == end && !finished) {
+			flushText();
+			return;
+		}
+		
 		switch (state) {
 			case State::Data: // Data state
-				if (it == inputStream.end()) {
+				if (it == end) {
 					// EOF
 					// Emit the end-of-file token.
 					emitEOFToken();
@@ -103,10 +202,18 @@ Queue<shared_ptr<Token>> &Tokenizer::tokenize(const string &inputStream) {
 						state = State::TagOpen;
 						break;
 
-					default:
+					case 0:
 						// Emit the current input character as a character token.
-						emitCharacterToken(*it);
+						emitCharacterToken(it);
+						break;
+
+					default: {
+						// 次の '<' '&' CR NULL の手前までは普通の文字なので，まとめて文字トークンにする
+						const char *next = findAny<'<', '&', '\r', 0>(it + 1, end);
+						emitCharacterTokens(it, next - it);
+						it = next - 1; // まとめた最後の文字まで進める
 						break;
+					}
 				}
 				break;
 
@@ -129,6 +236,14 @@ Queue<shared_ptr<Token>> &Tokenizer::tokenize(const string &inputStream) {
 				break;
 
 			case State::TagOpen: // Tag open state
+				if (it == end) {
+					// EOF
+					// Emit a U+003C LESS-THAN SIGN character token and reconsume the EOF character in the data state.
+					parseError();
+					emitCharacterToken('<');
+					state = State::Data;
+					continue;
+				}
 				switch (*it) {
 					case '!':
 						// Switch to the markup declaration open state.
@@ -165,7 +280,7 @@ Queue<shared_ptr<Token>> &Tokenizer::tokenize(const string &inputStream) {
 				break;
 
 			case State::EndTagOpen: // End tag open state
-				if (it == inputStream.end()) {
+				if (it == end) {
 					// Parse error. Emit a U+003C LESS-THAN SIGN character token and a U+002F SOLIDUS character token. Reconsume the EOF character in the data state.
 					parseError();
 					emitCharacterToken('<');
@@ -179,7 +294,7 @@ Queue<shared_ptr<Token>> &Tokenizer::tokenize(const string &inputStream) {
 					if (('A' <= *it && *it <= 'Z') || ('a' <= *it && *it <= 'z')) {
 						// Create a new end tag token, set its tag name to the current input character, then switch to the tag name state. (Don't emit the token yet; further details will be filled in before it is emitted.)
 						token.reset(new Token(Token::Type::EndTag));
-						token->data = ('A' <= *it && *it <= 'Z') ? *it + 0x20 : *it;
+						appendLower(token->data, it);
 						state = State::TagName;
 						break;
 					} else {
@@ -190,7 +305,7 @@ Queue<shared_ptr<Token>> &Tokenizer::tokenize(const string &inputStream) {
 				break;
 
 			case State::TagName: // Tag name state
-				if (it == inputStream.end()) {
+				if (it == end) {
 					// EOF
 					parseError();
 					state = State::Data;
@@ -226,13 +341,13 @@ Queue<shared_ptr<Token>> &Tokenizer::tokenize(const string &inputStream) {
 
 					default:
 						// Append the current input character to the current tag token's tag name.
-						token->data += ('A' <= *it && *it <= 'Z') ? *it + 0x20 : *it;
+						appendLower(token->data, it);
 						break;
 				}
 				break;
 
 			case State::BeforeAttributeName: // Before attribute name state
-				if (it == inputStream.end()) {
+				if (it == end) {
 					// EOF
 					parseError();
 					state = State::Data;
@@ -264,7 +379,11 @@ Queue<shared_ptr<Token>> &Tokenizer::tokenize(const string &inputStream) {
 					default:
 						// Start a new attribute in the current tag token.
 						// Set that attribute's name to the current input character, and its value to the empty string.
-						token->appendAttribute(('A' <= *it && *it <= 'Z') ? *it + 0x20 : *it);
+						if ('A' <= *it && *it <= 'Z') {
+							token->appendAttribute((char)(*it + 0x20));
+						} else {
+							token->appendAttribute(it);
+						}
 						// Switch to the attribute name state.
 						state = State::AttributeName;
 						break;
@@ -272,7 +391,7 @@ Queue<shared_ptr<Token>> &Tokenizer::tokenize(const string &inputStream) {
 				break;
 			
 			case State::AttributeName:
-				if (it == inputStream.end()) {
+				if (it == end) {
 					// EOF
 					parseError();
 					state = State::Data;
@@ -304,13 +423,17 @@ Queue<shared_ptr<Token>> &Tokenizer::tokenize(const string &inputStream) {
 					case '<':
 						parseError();
 					default:
-						token->appendAttributeName(('A' <= *it && *it <= 'Z') ? *it + 0x20 : *it);
+						if ('A' <= *it && *it <= 'Z') {
+							token->appendAttributeName((char)(*it + 0x20));
+						} else {
+							token->appendAttributeName(it);
+						}
 						break;
 				}
 				break;
 			
 			case State::AfterAttributeName:
-				if (it == inputStream.end()) {
+				if (it == end) {
 					// EOF
 					parseError();
 					state = State::Data;
@@ -344,7 +467,11 @@ Queue<shared_ptr<Token>> &Tokenizer::tokenize(const string &inputStream) {
 					default:
 						// Start a new attribute in the current tag token.
 						// Set that attribute's name to the current input character, and its value to the empty string.
-						token->appendAttribute(('A' <= *it && *it <= 'Z') ? *it + 0x20 : *it);
+						if ('A' <= *it && *it <= 'Z') {
+							token->appendAttribute((char)(*it + 0x20));
+						} else {
+							token->appendAttribute(it);
+						}
 						// Switch to the attribute name state.
 						state = State::AttributeName;
 						break;
@@ -352,7 +479,7 @@ Queue<shared_ptr<Token>> &Tokenizer::tokenize(const string &inputStream) {
 				break;
 			
 			case State::BeforeAttributeValue:
-				if (it == inputStream.end()) {
+				if (it == end) {
 					// EOF
 					parseError();
 					state = State::Data;
@@ -395,7 +522,7 @@ Queue<shared_ptr<Token>> &Tokenizer::tokenize(const string &inputStream) {
 				break;
 			
 			case State::AttributeValueDoubleQuoted:
-				if (it == inputStream.end()) {
+				if (it == end) {
 					// EOF
 					parseError();
 					state = State::Data;
@@ -412,13 +539,13 @@ Queue<shared_ptr<Token>> &Tokenizer::tokenize(const string &inputStream) {
 						break;
 					
 					default:
-						token->appendAttributeValue(*it);
+						token->appendAttributeValue(it);
 						break;
 				}
 				break;
 			
 			case State::AttributeValueSingleQuoted:
-				if (it == inputStream.end()) {
+				if (it == end) {
 					// EOF
 					parseError();
 					state = State::Data;
@@ -435,13 +562,13 @@ Queue<shared_ptr<Token>> &Tokenizer::tokenize(const string &inputStream) {
 						break;
 					
 					default:
-						token->appendAttributeValue(*it);
+						token->appendAttributeValue(it);
 						break;
 				}
 				break;
 			
 			case State::AttributeValueUnquoted:
-				if (it == inputStream.end()) {
+				if (it == end) {
 					// EOF
 					parseError();
 					state = State::Data;
@@ -472,7 +599,7 @@ Queue<shared_ptr<Token>> &Tokenizer::tokenize(const string &inputStream) {
 					case '`':
 						parseError();
 					default:
-						token->appendAttributeValue(*it);
+						token->appendAttributeValue(it);
 						break;
 				}
 				break;
@@ -481,7 +608,7 @@ Queue<shared_ptr<Token>> &Tokenizer::tokenize(const string &inputStream) {
 				break;
 			
 			case State::AfterAttributeValueQuoted:
-				if (it == inputStream.end()) {
+				if (it == end) {
 					// EOF
 					parseError();
 					state = State::Data;
@@ -512,7 +639,7 @@ Queue<shared_ptr<Token>> &Tokenizer::tokenize(const string &inputStream) {
 				break;
 
 			case State::SelfClosingStartTag: // Self-closing start tag state
-				if (it == inputStream.end()) { // EOF
+				if (it == end) { // EOF
 					parseError();
 					state = State::Data;
 					continue;
@@ -528,29 +655,33 @@ Queue<shared_ptr<Token>> &Tokenizer::tokenize(const string &inputStream) {
 				}
 				break;
 			
-			case State::MarkupDeclarationOpen:
-				if (inputStream.compare(i, 2, "--") == 0) {
+			case State::MarkupDeclarationOpen: {
+				// 先読みする文字がまだ届いていなければ，届くまで待つ
+				int match = lookahead("--", 2, false);
+				if (match < 0) return;
+				if (match) {
 					// create a comment token whose data is the empty string, and switch to the comment start state.
 					token.reset(new Token(Token::Type::Comment));
-					i += 2;
+					skip(2);
 					state = State::CommentStart;
 					continue;
-				} else if (inputStream.comparei(i, 7, "DOCTYPE") == 0) {
-					i += 7;
+				}
+				match = lookahead("DOCTYPE", 7, true);
+				if (match < 0) return;
+				if (match) {
+					skip(7);
 					state = State::DOCTYPE;
 					continue;
 				}
 				// Otherwise, if the insertion mode is "in foreign content" and the current node is not an element in the HTML namespace and the next seven characters are an case-sensitive match for the string "[CDATA[" (the five uppercase letters "CDATA" with a U+005B LEFT SQUARE BRACKET character before and after), then consume those characters and switch to the CDATA section state.
 				// Otherwise, this is a parse error. Switch to the bogus comment state. The next character that is consumed, if any, is the first character that will be in the comment.
-				else {
-					parseError();
-					state = State::BogusComment;
-					continue;
-				}
-				break;
+				parseError();
+				state = State::BogusComment;
+				continue;
+			}
 			
 			case State::CommentStart:
-				if (it == inputStream.end()) {
+				if (it == end) {
 					// EOF
 					parseError();
 					emitToken(token);
@@ -575,7 +706,7 @@ Queue<shared_ptr<Token>> &Tokenizer::tokenize(const string &inputStream) {
 				break;
 			
 			case State::CommentStartDash:
-				if (it == inputStream.end()) {
+				if (it == end) {
 					// EOF
 					parseError();
 					emitToken(token);
@@ -601,7 +732,7 @@ Queue<shared_ptr<Token>> &Tokenizer::tokenize(const string &inputStream) {
 				break;
 			
 			case State::Comment:
-				if (it == inputStream.end()) { // EOF
+				if (it == end) { // EOF
 					parseError();
 					emitToken(token);
 					state = State::Data;
@@ -609,12 +740,15 @@ Queue<shared_ptr<Token>> &Tokenizer::tokenize(const string &inputStream) {
 				} else if (*it == '-') {
 					state = State::CommentEndDash;
 				} else {
-					token->data += *it;
+					// 次の '-' の手前まではまとめてコメントに足す
+					const char *next = findAny<'-'>(it + 1, end);
+					token->data.append(it, next - it);
+					it = next - 1;
 				}
 				break;
 			
 			case State::CommentEndDash:
-				if (it == inputStream.end()) { // EOF
+				if (it == end) { // EOF
 					parseError();
 					emitToken(token);
 					state = State::Data;
@@ -629,7 +763,7 @@ Queue<shared_ptr<Token>> &Tokenizer::tokenize(const string &inputStream) {
 				break;
 			
 			case State::CommentEnd:
-				if (it == inputStream.end()) {
+				if (it == end) {
 					// EOF
 					parseError();
 					emitToken(token);
@@ -660,7 +794,7 @@ Queue<shared_ptr<Token>> &Tokenizer::tokenize(const string &inputStream) {
 				break;
 			
 			case State::CommentEndBang:
-				if (it == inputStream.end()) {
+				if (it == end) {
 					// EOF
 					parseError();
 					emitToken(token);
@@ -686,7 +820,7 @@ Queue<shared_ptr<Token>> &Tokenizer::tokenize(const string &inputStream) {
 				break;
 			
 			case State::DOCTYPE:
-				if (it == inputStream.end()) {
+				if (it == end) {
 					// EOF
 					// Parse error. Create a new DOCTYPE token. Set its force-quirks flag to on. Emit the token. Reconsume the EOF character in the data state.
 					parseError();
@@ -711,7 +845,7 @@ Queue<shared_ptr<Token>> &Tokenizer::tokenize(const string &inputStream) {
 				break;
 			
 			case State::BeforeDOCTYPEName:
-				if (it == inputStream.end()) {
+				if (it == end) {
 					// EOF
 					parseError();
 					state = State::Data;
@@ -742,14 +876,14 @@ Queue<shared_ptr<Token>> &Tokenizer::tokenize(const string &inputStream) {
 					default:
 						// create a new DOCTYPE token
 						token.reset(new Token(Token::Type::DOCTYPE));
-						token->data += ('A' <= *it && *it <= 'Z') ? *it + 0x20 : *it;
+						appendLower(token->data, it);
 						state = State::DOCTYPEName;
 						break;
 				}
 				break;
 			
 			case State::DOCTYPEName:
-				if (it == inputStream.end()) {
+				if (it == end) {
 					// EOF
 					// Set the DOCTYPE token's force-quirks flag to on. Emit that DOCTYPE token. Reconsume the EOF character in the data state.
 					// set force-quirks flag to on.
@@ -772,13 +906,13 @@ Queue<shared_ptr<Token>> &Tokenizer::tokenize(const string &inputStream) {
 						break;
 					
 					default:
-						token->data += ('A' <= *it && *it <= 'Z') ? *it + 0x20 : *it;
+						appendLower(token->data, it);
 						break;
 				}
 				break;
 			
 			case State::AfterDOCTYPEName:
-				if (it == inputStream.end()) {
+				if (it == end) {
 					// EOF
 					parseError();
 					// set force-quirks flag to on
@@ -799,15 +933,18 @@ Queue<shared_ptr<Token>> &Tokenizer::tokenize(const string &inputStream) {
 						emitToken(token);
 						break;
 					
-					default:
-						if (inputStream.comparei(i, 6, "public") == 0) {
+					default: {
+						int publicMatch = lookahead("public", 6, true);
+						int systemMatch = publicMatch ? 0 : lookahead("system", 6, true);
+						if (publicMatch < 0 || systemMatch < 0) return; // 届くまで待つ
+						if (publicMatch) {
 							// consume those characters and switch to the after DOCTYPE public keyword state.
-							i += 6;
+							skip(6);
 							state = State::AfterDOCTYPEPublicKeyword;
 							continue;
-						} else if (inputStream.comparei(i, 6, "system") == 0) {
+						} else if (systemMatch) {
 							// consume those characters and switch to the after DOCTYPE system keyword state.
-							i += 6;
+							skip(6);
 							state = State::AfterDOCTYPESystemKeyword;
 							continue;
 						} else {
@@ -816,11 +953,12 @@ Queue<shared_ptr<Token>> &Tokenizer::tokenize(const string &inputStream) {
 							state = State::BogusDOCTYPE;
 						}
 						break;
+					}
 				}
 				break;
 			
 			case State::AfterDOCTYPEPublicKeyword:
-				if (it == inputStream.end()) {
+				if (it == end) {
 					// EOF
 					parseError();
 					// force-quirks flag to on
@@ -866,7 +1004,7 @@ Queue<shared_ptr<Token>> &Tokenizer::tokenize(const string &inputStream) {
 				break;
 			
 			case State::BeforeDOCTYPEPublicIdentifier:
-				if (it == inputStream.end()) {
+				if (it == end) {
 					// EOF
 					parseError();
 					// force-quirks flag to on
@@ -912,7 +1050,7 @@ Queue<shared_ptr<Token>> &Tokenizer::tokenize(const string &inputStream) {
 				break;
 			
 			case State::DOCTYPEPublicIdentifierDoubleQuoted:
-				if (it == inputStream.end()) {
+				if (it == end) {
 					// EOF
 					parseError();
 					// force-quirks flag to on
@@ -939,7 +1077,7 @@ Queue<shared_ptr<Token>> &Tokenizer::tokenize(const string &inputStream) {
 				break;
 			
 			case State::DOCTYPEPublicIdentifierSingleQuoted:
-				if (it == inputStream.end()) {
+				if (it == end) {
 					// EOF
 					parseError();
 					// force-quirks flag to on
@@ -966,7 +1104,7 @@ Queue<shared_ptr<Token>> &Tokenizer::tokenize(const string &inputStream) {
 				break;
 			
 			case State::AfterDOCTYPEPublicIdentifier:
-				if (it == inputStream.end()) {
+				if (it == end) {
 					// EOF
 					parseError();
 					// force-quirks flag to on
@@ -1010,7 +1148,7 @@ Queue<shared_ptr<Token>> &Tokenizer::tokenize(const string &inputStream) {
 				break;
 			
 			case State::BetweenDOCTYPEPublicAndSystemIdentifiers:
-				if (it == inputStream.end()) {
+				if (it == end) {
 					// EOF
 					parseError();
 					// force-quirks flag to on
@@ -1054,7 +1192,7 @@ Queue<shared_ptr<Token>> &Tokenizer::tokenize(const string &inputStream) {
 				break;
 			
 			case State::AfterDOCTYPESystemKeyword:
-				if (it == inputStream.end()) {
+				if (it == end) {
 					// EOF
 					parseError();
 					// force-quirks flag to on
@@ -1098,7 +1236,7 @@ Queue<shared_ptr<Token>> &Tokenizer::tokenize(const string &inputStream) {
 				break;
 			
 			case State::BeforeDOCTYPESystemIdentifier:
-				if (it == inputStream.end()) {
+				if (it == end) {
 					// EOF
 					parseError();
 					// force-quirks flag to on
@@ -1142,7 +1280,7 @@ Queue<shared_ptr<Token>> &Tokenizer::tokenize(const string &inputStream) {
 				break;
 			
 			case State::DOCTYPESystemIdentifierDoubleQuoted:
-				if (it == inputStream.end()) {
+				if (it == end) {
 					// EOF
 					parseError();
 					// force-quirks flag to on
@@ -1169,7 +1307,7 @@ Queue<shared_ptr<Token>> &Tokenizer::tokenize(const string &inputStream) {
 				break;
 			
 			case State::DOCTYPESystemIdentifierSingleQuoted:
-				if (it == inputStream.end()) {
+				if (it == end) {
 					// EOF
 					parseError();
 					// force-quirks flag to on
@@ -1196,7 +1334,7 @@ Queue<shared_ptr<Token>> &Tokenizer::tokenize(const string &inputStream) {
 				break;
 			
 			case State::AfterDOCTYPESystemIdentifier:
-				if (it == inputStream.end()) {
+				if (it == end) {
 					// EOF
 					parseError();
 					// force-quirks flag to on
@@ -1226,7 +1364,7 @@ Queue<shared_ptr<Token>> &Tokenizer::tokenize(const string &inputStream) {
 				break;
 			
 			case State::BogusDOCTYPE:
-				if (it == inputStream.end()) { // EOF
+				if (it == end) { // EOF
 					emitToken(token);
 					state = State::Data;
 					continue;
@@ -1243,33 +1381,63 @@ Queue<shared_ptr<Token>> &Tokenizer::tokenize(const string &inputStream) {
 		}
 		
 		// TODO: 本来はこれがなくても無限ループは起こらないはずなので，解決したら外す
-		if (it == inputStream.end()) {
+		if (it == end) {
 			// EOF
+			flushText();
 			endFlag = true;
 			continue;
 		}
 		
-		++it;
-		++i;
+		advance();
+	}
+}
+
+static inline bool isSpace(char c) {
+	return c == 0x09 || c == 0x0a || c == 0x0c || c == 0x0d || c == ' ';
+}
+
+// 続いている文字は1つの文字トークンにまとめる
+// (ツリー構築で扱いが変わるので，先頭の空白だけの部分と NULL は別のトークンにする)
+Token &Tokenizer::characterToken(char c) {
+	if (text && (c == 0 || (textSpace && !isSpace(c)))) flushText();
+	if (!text) {
+		text.reset(new Token(Token::Type::Character));
+		textSpace = isSpace(c);
+	}
+	return *text;
+}
+
+void Tokenizer::flushText() {
+	if (text) tokens.push(intrusive_ptr<Token>(text.release()));
+}
+
+// p から n 文字 (NULL は含まない) を文字トークンに足す
+void Tokenizer::emitCharacterTokens(const char *p, unsigned int n) {
+	// 先頭の空白だけの部分は分けるので，空白でない文字が来るまでは1文字ずつ
+	for (; n && (!text || textSpace); ++p, --n) {
+		emitCharacterToken(p);
 	}
-	
-	return tokens;
+	if (n) text->data.append(p, n);
+}
+
+void Tokenizer::emitCharacterToken(const char *p) {
+	characterToken(*p).data.append(p);
+	if (*p == 0) flushText();
 }
 
 void Tokenizer::emitCharacterToken(char c) {
-	shared_ptr<Token> token(new Token(Token::Type::Character));
-	token->data += c;
-	tokens.push(token);
+	characterToken(c).data += c;
+	if (c == 0) flushText();
 }
 
 void Tokenizer::emitEOFToken() {
-	tokens.push(shared_ptr<Token>(new Token(Token::Type::EndOfFile)));
+	flushText();
+	tokens.push(intrusive_ptr<Token>(new Token(Token::Type::EndOfFile)));
 }
 
 void Tokenizer::emitToken(unique_ptr<Token> &token) {
-	// 現在のままではよくない．
-	// std::move 相当のものを実装したら修正するべき
-	tokens.push(shared_ptr<Token>(token.release()));
+	flushText();
+	tokens.push(intrusive_ptr<Token>(token.release()));
 }
 
 void Tokenizer::parseError() {}
@@ -1,24 +1,49 @@
 #pragma once
 
 #include <Queue.h>
-#include <pistring.h>
+#include <Vector.h>
+#include <StringView.h>
 #include <SmartPointer.h>
 #include "HTMLToken.h"
 
 namespace HTML {
+	/*
+	 * next() を呼ぶたびにトークンを1つ作って返す (作ったトークンを溜めておかない)．
+	 * 入力は feed() で何回かに分けて渡せるので，ファイルを全部読み終える前から始められる．
+	 * 最後まで渡したら finish() を呼ぶ (それまでは入力の終わりを EOF として扱わない)．
+	 */
 	class Tokenizer {
 	private:
 		enum class State;
-		Queue<shared_ptr<Token>> tokens;
-		
+		State state;
+		unique_ptr<Token> token; // 作りかけのトークン
+		unique_ptr<Token> text;  // 作りかけの文字トークン
+		bool textSpace = false;  // text が空白だけか
+		Queue<intrusive_ptr<Token>> tokens; // 1文字で2つ出ることがあるので，渡す前に少しだけ置いておく
+		const char *it = nullptr, *end = nullptr; // 今読んでいる入力
+		Vector<string_view> rest; // その後に渡された入力
+		int restHead = 0;
+		bool finished = false, endFlag = false;
+
+		void run();
+		void advance();
+		void skip(int n);
+		int lookahead(const char *word, int n, bool ignoreCase) const;
+		Token &characterToken(char c);
+		void flushText();
+		void emitCharacterToken(const char *p);
+		void emitCharacterTokens(const char *p, unsigned int n);
 		void emitCharacterToken(char c);
 		void emitEOFToken();
 		void emitToken(unique_ptr<Token> &token);
 		void parseError();
-	
+
 	public:
 		Tokenizer();
-		Queue<shared_ptr<Token>> &tokenize(const string &inputStream);
+		// トークンは入力を指すので，渡した入力はトークンを使い終わるまで残しておくこと
+		void feed(string_view input);
+		void finish();
+		// 次のトークン (入力が足りないか，EOF トークンを返し終わっていれば nullptr)
+		intrusive_ptr<Token> next();
 	};
 }
-
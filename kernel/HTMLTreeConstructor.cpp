@@ -1,5 +1,6 @@
 #include <Stack.h>
 #include "HTMLTreeConstructor.h"
+#include "HTMLAtom.h"
 
 using namespace HTML;
 
@@ -29,17 +30,29 @@ enum class TreeConstructor::Mode {
 	AfterAfterFrameseet
 };
 
-Document &TreeConstructor::construct(Queue<shared_ptr<Token>> &tokens) {
-	Mode mode = Mode::Initial;
-	shared_ptr<Token> token;
-	Stack<shared_ptr<Node>> openTags(256); // stack of open elements
-	bool scripting = false; // scripting flag
-	
-	if (tokens.isempty()) return document;
-	token = tokens.pop();
-	
-	// token 取り出し
-	do {
+// 空白だけの文字トークンか (トークナイザーが先頭の空白を別のトークンにしてある)
+static bool isSpaceRun(string_view data) {
+	for (char c : data) {
+		if (c != 0x09 && c != 0x0a && c != 0x0c && c != 0x0d && c != ' ') return false;
+	}
+	return true;
+}
+
+TreeConstructor::TreeConstructor() : mode(Mode::Initial), openTags(256) {}
+
+intrusive_ptr<Node> TreeConstructor::createElement(Atom name) {
+	return intrusive_ptr<Node>(new Element(name, document.atoms.nameOf(name)));
+}
+
+Document &TreeConstructor::construct(Tokenizer &tokenizer) {
+	// token 取り出し (tokenizer が入力を待っているときは，ここまでで一旦戻る)
+	for (intrusive_ptr<Token> token = tokenizer.next(); token;) {
+		// タグ名を文書の Atom にして，文字列で比べずに Tag で分ける (タグ以外のトークンは 0 なので Tag::Unknown)
+		if (token->type == Token::Type::StartTag || token->type == Token::Type::EndTag) {
+			token->internNames(document.atoms);
+		}
+		Tag tag = TagOf(token->tagName);
+		
 		switch (mode) {
 			case Mode::Initial:
 				switch (token->type) {
@@ -54,7 +67,7 @@ Document &TreeConstructor::construct(Queue<shared_ptr<Token>> &tokens) {
 					case Token::Type::DOCTYPE:
 						/* parseError の条件あり */
 						
-						document.appendChild(shared_ptr<Node>(new DocumentType(token->data)));
+						document.appendChild(intrusive_ptr<Node>(new DocumentType(token->data)));
 						// publicId and systemId も
 						
 						mode = Mode::BeforeHtml;
@@ -72,7 +85,7 @@ Document &TreeConstructor::construct(Queue<shared_ptr<Token>> &tokens) {
 			case Mode::BeforeHtml: {
 				auto actAsAnythingElse = [&] {
 					// Create an html element. Append it to the Document object. Put this element in the stack of open elements.
-					shared_ptr<Node> elem(new Element(token->data));
+					intrusive_ptr<Node> elem(createElement(AtomOf(Tag::Html)));
 					document.appendChild(elem);
 					openTags.push(elem);
 	
@@ -96,9 +109,9 @@ Document &TreeConstructor::construct(Queue<shared_ptr<Token>> &tokens) {
 						break;
 					
 					case Token::Type::StartTag:
-						if (token->data == "html") {
+						if (tag == Tag::Html) {
 							// Create an element for the token in the HTML namespace.
-							shared_ptr<Node> elem(new Element(token->data));
+							intrusive_ptr<Node> elem(createElement(token->tagName));
 							// Append it to the Document object.
 							document.appendChild(elem);
 							// Put this element in the stack of open elements.
@@ -121,7 +134,7 @@ Document &TreeConstructor::construct(Queue<shared_ptr<Token>> &tokens) {
 						break;
 					
 					case Token::Type::EndTag:
-						if (token->data == "head" || token->data == "body" || token->data == "html" || token->data == "br") {
+						if (tag == Tag::Head || tag == Tag::Body || tag == Tag::Html || tag == Tag::Br) {
 							actAsAnythingElse();
 							continue;
 						} else {
@@ -148,7 +161,7 @@ Document &TreeConstructor::construct(Queue<shared_ptr<Token>> &tokens) {
 				};
 				switch (token->type) {
 					case Token::Type::Character:
-						if (token->data == "\t" || token->data == "\n" || token->data == "\f" || token->data == "\r" || token->data == " ") {
+						if (isSpaceRun(token->data)) {
 							// ignore
 						} else {
 							actAsAnythingElse();
@@ -166,12 +179,12 @@ Document &TreeConstructor::construct(Queue<shared_ptr<Token>> &tokens) {
 						break;
 					
 					case Token::Type::StartTag:
-						if (token->data == "html") {
+						if (tag == Tag::Html) {
 							mode = Mode::InBody;
 							continue;
-						} else if (token->data == "head") {
+						} else if (tag == Tag::Head) {
 							// Insert an HTML element for the token.
-							shared_ptr<Node> elem(new Element(token->data));
+							intrusive_ptr<Node> elem(createElement(token->tagName));
 							openTags.top()->appendChild(elem);
 							openTags.push(elem);
 							
@@ -182,7 +195,7 @@ Document &TreeConstructor::construct(Queue<shared_ptr<Token>> &tokens) {
 						break;
 					
 					case Token::Type::EndTag:
-						if (token->data == "head" || token->data == "body" || token->data == "html" || token->data == "br") {
+						if (tag == Tag::Head || tag == Tag::Body || tag == Tag::Html || tag == Tag::Br) {
 							actAsAnythingElse();
 							continue;
 						} else {
@@ -214,40 +227,71 @@ Document &TreeConstructor::construct(Queue<shared_ptr<Token>> &tokens) {
 						break;
 					
 					case Token::Type::StartTag:
-						if (token->data == "html") {
-							
-						} else if (token->data == "base" || token->data == "basefont" || token->data == "bgsound" || token->data == "link") {
-							
-						} else if (token->data == "meta") {
-							
-						} else if (token->data == "title") {
-							// Follow the generic RCDATA element parsing algorithm.
-						} else if ((token->data == "noscript" && scripting) || token->data == "noframes" || token->data == "style") {
-							
-						} else if (token->data == "noscript") { // && !scripting
-							
-						} else if (token->data == "script") {
-							
-						} else if (token->data == "template") {
-							
-						} else if (token->data == "head") {
-							parseError();
-							// ignore
+						switch (tag) {
+							case Tag::Html:
+								break;
+							
+							case Tag::Base:
+							case Tag::Basefont:
+							case Tag::Bgsound:
+							case Tag::Link:
+								break;
+							
+							case Tag::Meta:
+								break;
+							
+							case Tag::Title:
+								// Follow the generic RCDATA element parsing algorithm.
+								break;
+							
+							case Tag::Noframes:
+							case Tag::Style:
+								break;
+							
+							case Tag::Noscript:
+								if (scripting) {
+									// noframes, style と同じ
+								} else {
+									
+								}
+								break;
+							
+							case Tag::Script:
+								break;
+							
+							case Tag::Template:
+								break;
+							
+							case Tag::Head:
+								parseError();
+								// ignore
+								break;
+							
+							default:
+								break;
 						}
 						break;
 					
 					case Token::Type::EndTag:
-						if (token->data == "head") {
-							openTags.pop();
-							mode = Mode::AfterHead;
-						} else if (token->data == "body" || token->data == "html" || token->data == "br") {
-							actAsAnythingElse();
-							continue;
-						} else if (token->data == "template") {
-							
-						} else {
-							parseError();
-							// ignore
+						switch (tag) {
+							case Tag::Head:
+								openTags.pop();
+								mode = Mode::AfterHead;
+								break;
+							
+							case Tag::Body:
+							case Tag::Html:
+							case Tag::Br:
+								actAsAnythingElse();
+								continue;
+							
+							case Tag::Template:
+								break;
+							
+							default:
+								parseError();
+								// ignore
+								break;
 						}
 						break;
 					
@@ -273,39 +317,48 @@ Document &TreeConstructor::construct(Queue<shared_ptr<Token>> &tokens) {
 						break;
 					
 					case Token::Type::StartTag:
-						if (token->data == "html") {
-							
-						} else if (token->data == "body") {
-							openTags.push(openTags.top()->appendChild(shared_ptr<Node>(new Element(token->data))));
-							
-							// Set the frameset-ok flag to "not ok".
-							
-							mode = Mode::InBody;
-						} else if (token->data == "frameset") {
-							
-						} else if (token->data == "base"
-						|| token->data == "basefont"
-						|| token->data == "bgsound"
-						|| token->data == "link"
-						|| token->data == "meta"
-						|| token->data == "noframes"
-						|| token->data == "script"
-						|| token->data == "style"
-						|| token->data == "template"
-						|| token->data == "title") {
-							parseError();
-							
-							
-						} else if (token->data == "head") {
-							parseError();
-							// ignore
+						switch (tag) {
+							case Tag::Html:
+								break;
+							
+							case Tag::Body:
+								openTags.push(openTags.top()->appendChild(createElement(token->tagName)));
+								
+								// Set the frameset-ok flag to "not ok".
+								
+								mode = Mode::InBody;
+								break;
+							
+							case Tag::Frameset:
+								break;
+							
+							case Tag::Base:
+							case Tag::Basefont:
+							case Tag::Bgsound:
+							case Tag::Link:
+							case Tag::Meta:
+							case Tag::Noframes:
+							case Tag::Script:
+							case Tag::Style:
+							case Tag::Template:
+							case Tag::Title:
+								parseError();
+								break;
+							
+							case Tag::Head:
+								parseError();
+								// ignore
+								break;
+							
+							default:
+								break;
 						}
 						break;
 					
 					case Token::Type::EndTag:
-						if (token->data == "template") {
+						if (tag == Tag::Template) {
 							
-						} else if (token->data == "body" || token->data == "html" || token->data == "br") {
+						} else if (tag == Tag::Body || tag == Tag::Html || tag == Tag::Br) {
 							 
 						} else {
 							parseError();
@@ -321,20 +374,16 @@ Document &TreeConstructor::construct(Queue<shared_ptr<Token>> &tokens) {
 			case Mode::InBody:
 				switch (token->type) {
 					case Token::Type::Character:
-						/*if (token->data == 0) {
+						if (token->data == string_view("\0", 1)) {
 							parseError();
 							// ignore
-						} else */
-						if (token->data == "\t" || token->data == "\n" || token->data == "\f" || token->data == "\r" || token->data == " ") {
-							// Reconstruct the active formatting elements, if any.
-
-							// Insert the token's character.
 						} else {
 							// Reconstruct the active formatting elements, if any.
 
-							// Insert the token's character.
+							// Insert the token's character. (続いた文字は1つのトークンなので，まとめて足す)
+							insertCharacters(token->data);
 
-							// Set the frameset-ok flag to "not ok".
+							// 空白だけでなければ Set the frameset-ok flag to "not ok".
 						}
 						break;
 					
@@ -347,236 +396,305 @@ Document &TreeConstructor::construct(Queue<shared_ptr<Token>> &tokens) {
 						break;
 					
 					case Token::Type::StartTag:
-						if (token->data == "html") {
-							
-						} else if (token->data == "base"
-						|| token->data == "basefont"
-						|| token->data == "bgsound"
-						|| token->data == "link"
-						|| token->data == "meta"
-						|| token->data == "noframes"
-						|| token->data == "script"
-						|| token->data == "style"
-						|| token->data == "template"
-						|| token->data == "title") {
-							
-						} else if (token->data == "body") {
-							
-						} else if (token->data == "frameset") {
-							
-						} else if (token->data == "address"
-						|| token->data == "article"
-						|| token->data == "aside"
-						|| token->data == "blockquote"
-						|| token->data == "center"
-						|| token->data == "details"
-						|| token->data == "dialog"
-						|| token->data == "dir"
-						|| token->data == "div"
-						|| token->data == "dl"
-						|| token->data == "fieldset"
-						|| token->data == "figcaption"
-						|| token->data == "figure"
-						|| token->data == "footer"
-						|| token->data == "header"
-						|| token->data == "hgroup"
-						|| token->data == "main"
-						|| token->data == "menu"
-						|| token->data == "nav"
-						|| token->data == "ol"
-						|| token->data == "p"
-						|| token->data == "section"
-						|| token->data == "summary"
-						|| token->data == "ul") {
-							// If the stack of open elements does not have an element in scope that is an HTML element with
-							// the same tag name as that of the token, then this is a parse error; ignore the token.
+						switch (tag) {
+							case Tag::Html:
+								break;
+							
+							case Tag::Base:
+							case Tag::Basefont:
+							case Tag::Bgsound:
+							case Tag::Link:
+							case Tag::Meta:
+							case Tag::Noframes:
+							case Tag::Script:
+							case Tag::Style:
+							case Tag::Template:
+							case Tag::Title:
+								break;
+							
+							case Tag::Body:
+								break;
+							
+							case Tag::Frameset:
+								break;
+							
+							case Tag::Address:
+							case Tag::Article:
+							case Tag::Aside:
+							case Tag::Blockquote:
+							case Tag::Center:
+							case Tag::Details:
+							case Tag::Dialog:
+							case Tag::Dir:
+							case Tag::Div:
+							case Tag::Dl:
+							case Tag::Fieldset:
+							case Tag::Figcaption:
+							case Tag::Figure:
+							case Tag::Footer:
+							case Tag::Header:
+							case Tag::Hgroup:
+							case Tag::Main:
+							case Tag::Menu:
+							case Tag::Nav:
+							case Tag::Ol:
+							case Tag::P:
+							case Tag::Section:
+							case Tag::Summary:
+							case Tag::Ul:
+								// If the stack of open elements does not have an element in scope that is an HTML element with
+								// the same tag name as that of the token, then this is a parse error; ignore the token.
 
-							// Otherwise, run these steps:
-							// 1. Generate implied end tags.
-							// 2. If the current node is not an HTML element with the same tag name as that of the token, then this is a parse error.
-							// 3. Pop elements from the stack of open elements until an HTML element with the same tag name as the token has been popped from the stack.
-						} else if (token->data == "h1"
-						|| token->data == "h2"
-						|| token->data == "h3"
-						|| token->data == "h4"
-						|| token->data == "h5"
-						|| token->data == "h6") {
-							openTags.push(openTags.top()->appendChild(shared_ptr<Node>(new Element(token->data))));
-							// If the stack of open elements does not have an element in scope that is an HTML element and
-							// whose tag name is one of "h1", "h2", "h3", "h4", "h5", or "h6", then this is a parse error; ignore the token.
+								// Otherwise, run these steps:
+								// 1. Generate implied end tags.
+								// 2. If the current node is not an HTML element with the same tag name as that of the token, then this is a parse error.
+								// 3. Pop elements from the stack of open elements until an HTML element with the same tag name as the token has been popped from the stack.
+								break;
+							
+							case Tag::H1:
+							case Tag::H2:
+							case Tag::H3:
+							case Tag::H4:
+							case Tag::H5:
+							case Tag::H6:
+								openTags.push(openTags.top()->appendChild(createElement(token->tagName)));
+								// If the stack of open elements does not have an element in scope that is an HTML element and
+								// whose tag name is one of "h1", "h2", "h3", "h4", "h5", or "h6", then this is a parse error; ignore the token.
 
-							// Otherwise, run these steps:
-							// 1. Generate implied end tags.
-							// 2. If the current node is not an HTML element with the same tag name as that of the token, then this is a parse error.
-							// 3. Pop elements from the stack of open elements until an HTML element whose tag name is one of "h1", "h2", "h3", "h4", "h5", or "h6" has been popped from the stack.
-						} else if (token->data == "pre" || token->data == "listing") {
-							
-						} else if (token->data == "form") {
-							
-						} else if (token->data == "li") {
-							
-						} else if (token->data == "dd" || token->data == "dt") {
-							
-						} else if (token->data == "plaintext") {
-							
-						} else if (token->data == "button") {
-							
-						} else if (token->data == "a") {
-							
-						} else if (token->data == "b"
-						|| token->data == "big"
-						|| token->data == "code"
-						|| token->data == "em"
-						|| token->data == "font"
-						|| token->data == "i"
-						|| token->data == "s"
-						|| token->data == "small"
-						|| token->data == "strike"
-						|| token->data == "strong"
-						|| token->data == "tt"
-						|| token->data == "u") {
-							
-						} else if (token->data == "nobr") {
-							
-						} else if (token->data == "applet" || token->data == "marquee" || token->data == "object") {
-							
-						} else if (token->data == "table") {
-							
-						} else if (token->data == "area"
-						|| token->data == "br"
-						|| token->data == "embed"
-						|| token->data == "img"
-						|| token->data == "keygen"
-						|| token->data == "wbr") {
-							
-						} else if (token->data == "input") {
-							
-						} else if (token->data == "menuitem"
-						|| token->data == "param"
-						|| token->data == "source"
-						|| token->data == "track") {
-							
-						} else if (token->data == "hr") {
-							
-						} else if (token->data == "image") {
-							
-						} else if (token->data == "isindex") {
-							
-						} else if (token->data == "textarea") {
-							
-						} else if (token->data == "xmp") {
-							
-						} else if (token->data == "iframe") {
-							
-						} else if (token->data == "noembed" || (token->data == "noscript" && scripting)) {
-							
-						} else if (token->data == "select") {
-							
-						} else if (token->data == "optgroup" || token->data == "option") {
-							
-						} else if (token->data == "rp" || token->data == "rt") {
-							
-						} else if (token->data == "math") {
-							
-						} else if (token->data == "svg") {
-							
-						} else if (token->data == "caption"
-						|| token->data == "col"
-						|| token->data == "colgroup"
-						|| token->data == "frame"
-						|| token->data == "head"
-						|| token->data == "tbody"
-						|| token->data == "td"
-						|| token->data == "tfoot"
-						|| token->data == "th"
-						|| token->data == "thead"
-						|| token->data == "tr") {
-							
-						} else {
-							
+								// Otherwise, run these steps:
+								// 1. Generate implied end tags.
+								// 2. If the current node is not an HTML element with the same tag name as that of the token, then this is a parse error.
+								// 3. Pop elements from the stack of open elements until an HTML element whose tag name is one of "h1", "h2", "h3", "h4", "h5", or "h6" has been popped from the stack.
+								break;
+							
+							case Tag::Pre:
+							case Tag::Listing:
+								break;
+							
+							case Tag::Form:
+								break;
+							
+							case Tag::Li:
+								break;
+							
+							case Tag::Dd:
+							case Tag::Dt:
+								break;
+							
+							case Tag::Plaintext:
+								break;
+							
+							case Tag::Button:
+								break;
+							
+							case Tag::A:
+								break;
+							
+							case Tag::B:
+							case Tag::Big:
+							case Tag::Code:
+							case Tag::Em:
+							case Tag::Font:
+							case Tag::I:
+							case Tag::S:
+							case Tag::Small:
+							case Tag::Strike:
+							case Tag::Strong:
+							case Tag::Tt:
+							case Tag::U:
+								break;
+							
+							case Tag::Nobr:
+								break;
+							
+							case Tag::Applet:
+							case Tag::Marquee:
+							case Tag::Object:
+								break;
+							
+							case Tag::Table:
+								break;
+							
+							case Tag::Area:
+							case Tag::Br:
+							case Tag::Embed:
+							case Tag::Img:
+							case Tag::Keygen:
+							case Tag::Wbr:
+								break;
+							
+							case Tag::Input:
+								break;
+							
+							case Tag::Menuitem:
+							case Tag::Param:
+							case Tag::Source:
+							case Tag::Track:
+								break;
+							
+							case Tag::Hr:
+								break;
+							
+							case Tag::Image:
+								break;
+							
+							case Tag::Isindex:
+								break;
+							
+							case Tag::Textarea:
+								break;
+							
+							case Tag::Xmp:
+								break;
+							
+							case Tag::Iframe:
+								break;
+							
+							case Tag::Noembed:
+								break;
+							
+							case Tag::Noscript:
+								if (scripting) {
+									// noembed と同じ
+								} else {
+									// その他の開始タグと同じ
+								}
+								break;
+							
+							case Tag::Select:
+								break;
+							
+							case Tag::Optgroup:
+							case Tag::Option:
+								break;
+							
+							case Tag::Rp:
+							case Tag::Rt:
+								break;
+							
+							case Tag::Math:
+								break;
+							
+							case Tag::Svg:
+								break;
+							
+							case Tag::Caption:
+							case Tag::Col:
+							case Tag::Colgroup:
+							case Tag::Frame:
+							case Tag::Head:
+							case Tag::Tbody:
+							case Tag::Td:
+							case Tag::Tfoot:
+							case Tag::Th:
+							case Tag::Thead:
+							case Tag::Tr:
+								break;
+							
+							default:
+								break;
 						}
 						break;
 					
 					case Token::Type::EndTag:
-						if (token->data == "template") {
-							// Process the token using the rules for the "in head" insertion mode.
-						} else if (token->data == "body") {
-							// If the stack of open elements does not have a body element in scope, this is a parse error; ignore the token.
+						switch (tag) {
+							case Tag::Template:
+								// Process the token using the rules for the "in head" insertion mode.
+								break;
+							
+							case Tag::Body:
+								// If the stack of open elements does not have a body element in scope, this is a parse error; ignore the token.
 
-							// Otherwise, if there is a node in the stack of open elements that is not either
-							// a dd element, a dt element, an li element, an optgroup element, an option element,
-							// a p element, an rp element, an rt element, a tbody element, a td element, a tfoot element,
-							// a th element, a thead element, a tr element, the body element, or the html element,
-							// then this is a parse error.
+								// Otherwise, if there is a node in the stack of open elements that is not either
+								// a dd element, a dt element, an li element, an optgroup element, an option element,
+								// a p element, an rp element, an rt element, a tbody element, a td element, a tfoot element,
+								// a th element, a thead element, a tr element, the body element, or the html element,
+								// then this is a parse error.
 
-							// Switch the insertion mode to "after body".
-							mode = Mode::AfterBody;
-						} else if (token->data == "html") {
-							
-						} else if (token->data == "address"
-						|| token->data == "article"
-						|| token->data == "aside"
-						|| token->data == "blockquote"
-						|| token->data == "button"
-						|| token->data == "center"
-						|| token->data == "details"
-						|| token->data == "dialog"
-						|| token->data == "dir"
-						|| token->data == "div"
-						|| token->data == "dl"
-						|| token->data == "fieldset"
-						|| token->data == "figcaption"
-						|| token->data == "figure"
-						|| token->data == "footer"
-						|| token->data == "header"
-						|| token->data == "hgroup"
-						|| token->data == "main"
-						|| token->data == "menu"
-						|| token->data == "nav"
-						|| token->data == "ol"
-						|| token->data == "pre"
-						|| token->data == "section"
-						|| token->data == "summary"
-						|| token->data == "ul") {
-							
-						} else if (token->data == "form") {
-							
-						} else if (token->data == "p") {
-							
-						} else if (token->data == "li") {
-							
-						} else if (token->data == "dd" || token->data == "dt") {
-							
-						} else if (token->data == "h1"
-						|| token->data == "h2"
-						|| token->data == "h3"
-						|| token->data == "h4"
-						|| token->data == "h5"
-						|| token->data == "h6") {
-							
-						} else if (token->data == "sarcasm") {
-							
-						} else if (token->data == "a"
-						|| token->data == "b"
-						|| token->data == "big"
-						|| token->data == "code"
-						|| token->data == "em"
-						|| token->data == "font"
-						|| token->data == "i"
-						|| token->data == "nobr"
-						|| token->data == "s"
-						|| token->data == "small"
-						|| token->data == "strike"
-						|| token->data == "strong"
-						|| token->data == "tt"
-						|| token->data == "u") {
-							
-						} else if (token->data == "applet" || token->data == "marquee" || token->data == "object") {
-							
-						} else if (token->data == "br") {
-							
-						} else {
-							
+								// Switch the insertion mode to "after body".
+								mode = Mode::AfterBody;
+								break;
+							
+							case Tag::Html:
+								break;
+							
+							case Tag::Address:
+							case Tag::Article:
+							case Tag::Aside:
+							case Tag::Blockquote:
+							case Tag::Button:
+							case Tag::Center:
+							case Tag::Details:
+							case Tag::Dialog:
+							case Tag::Dir:
+							case Tag::Div:
+							case Tag::Dl:
+							case Tag::Fieldset:
+							case Tag::Figcaption:
+							case Tag::Figure:
+							case Tag::Footer:
+							case Tag::Header:
+							case Tag::Hgroup:
+							case Tag::Main:
+							case Tag::Menu:
+							case Tag::Nav:
+							case Tag::Ol:
+							case Tag::Pre:
+							case Tag::Section:
+							case Tag::Summary:
+							case Tag::Ul:
+								break;
+							
+							case Tag::Form:
+								break;
+							
+							case Tag::P:
+								break;
+							
+							case Tag::Li:
+								break;
+							
+							case Tag::Dd:
+							case Tag::Dt:
+								break;
+							
+							case Tag::H1:
+							case Tag::H2:
+							case Tag::H3:
+							case Tag::H4:
+							case Tag::H5:
+							case Tag::H6:
+								break;
+							
+							case Tag::Sarcasm:
+								break;
+							
+							case Tag::A:
+							case Tag::B:
+							case Tag::Big:
+							case Tag::Code:
+							case Tag::Em:
+							case Tag::Font:
+							case Tag::I:
+							case Tag::Nobr:
+							case Tag::S:
+							case Tag::Small:
+							case Tag::Strike:
+							case Tag::Strong:
+							case Tag::Tt:
+							case Tag::U:
+								break;
+							
+							case Tag::Applet:
+							case Tag::Marquee:
+							case Tag::Object:
+								break;
+							
+							case Tag::Br:
+								break;
+							
+							default:
+								break;
 						}
 						break;
 					
@@ -633,7 +751,7 @@ Document &TreeConstructor::construct(Queue<shared_ptr<Token>> &tokens) {
 						break;
 					
 					case Token::Type::EndTag:
-						if (token->data == "html") {
+						if (tag == Tag::Html) {
 							// If the parser was originally created as part of the HTML fragment parsing algorithm, this is a parse error;
 							// ignore the token. (fragment case)
 							
@@ -685,12 +803,23 @@ Document &TreeConstructor::construct(Queue<shared_ptr<Token>> &tokens) {
 				break;
 		}
 		
-		token = tokens.pop();
-	} while (!tokens.isempty());
+		token = tokenizer.next();
+	}
 	
 	return document;
 }
 
+// 今のノードの最後の子が文字ノードならそこに足し，そうでなければ文字ノードを作る
+void TreeConstructor::insertCharacters(string_view data) {
+	Node &parent = *openTags.top();
+	if (lastText && !parent.children.empty() && parent.children.back().get() == lastText) {
+		lastText->appendData(data);
+	} else {
+		lastText = new TextNode(string(data));
+		parent.appendChild(intrusive_ptr<Node>(lastText));
+	}
+}
+
 void TreeConstructor::parseError() {
 	
 }
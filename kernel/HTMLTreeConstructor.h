@@ -1,19 +1,28 @@
 #pragma once
 
-#include <Queue.h>
+#include <Stack.h>
 #include <SmartPointer.h>
 #include "HTMLToken.h"
+#include "HTMLTokenizer.h"
 #include "HTMLNode.h"
 
 namespace HTML {
 	class TreeConstructor {
 	private:
 		enum class Mode;
+		Mode mode;
+		Stack<intrusive_ptr<Node>> openTags; // stack of open elements
+		bool scripting = false; // scripting flag
+		TextNode *lastText = nullptr; // 最後に文字を足した文字ノード
 		Document document;
+		
+		void insertCharacters(string_view data);
+		intrusive_ptr<Node> createElement(Atom name);
 	
 	public:
-		TreeConstructor() {}
-		Document &construct(Queue<shared_ptr<Token>> &tokens);
+		TreeConstructor();
+		// tokenizer から取り出せるだけトークンを取り出して木を作る (入力が足りなければ，続きを渡してからもう一度呼ぶ)
+		Document &construct(Tokenizer &tokenizer);
 		void parseError();
 	};
 }
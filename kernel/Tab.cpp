@@ -33,13 +33,27 @@ Tab::Tab(const string &tabName) : index(SheetCtl::numOfTab++), tabBar(new Sheet(
 	active();
 }
 
+// タスクが動き出す前に Arena を渡す
 Tab::Tab(const string &tabName, void (*mainLoop)(Tab *)) : Tab(tabName) {
 	int args[] = { (int)this };
+	int e = LoadEflags();
+	Cli();
 	task = new Task(name, 3, 2, mainLoop, args);
+	task->arena = arena = ArenaCreate();
+	StoreEflags(e);
 }
 Tab::Tab(const string &tabName, int queueSize, void (*mainLoop)(Tab *)) : Tab(tabName) {
 	int args[] = { (int)this };
+	int e = LoadEflags();
+	Cli();
 	task = new Task(name, 3, 2, queueSize, mainLoop, args);
+	task->arena = arena = ArenaCreate();
+	StoreEflags(e);
+}
+
+// タブのシートを全部描いても足りるだけの空きがあるか
+bool Tab::canOpen() {
+	return MemoryTotal() >= (SheetCtl::resolution.width - 150) * SheetCtl::resolution.height * sizeof(unsigned int);
 }
 
 Tab::~Tab() {
@@ -78,7 +92,10 @@ Tab::~Tab() {
 	// その他の解放
 	delete sheet;
 	if (timer) delete timer;
+	if (watcher) UnregisterMemoryWatcher(watcher);
 	if (task) delete task;
+	// タブのタスクが確保したものをまとめて返す
+	ArenaRelease(arena);
 }
 
 void Tab::active() {
@@ -5,6 +5,7 @@
 class Tab {
 private:
 	Task *task = nullptr;
+	Arena *arena = nullptr;
 	int index;
 	Sheet *tabBar;
 	
@@ -13,10 +14,12 @@ private:
 public:
 	Sheet *sheet;
 	Timer *timer = nullptr;
+	MemoryWatcher *watcher = nullptr;
 	string name;
 	
 	Tab(const string &tabName, void (*mainLoop)(Tab *));
 	Tab(const string &tabName, int queueSize, void (*mainLoop)(Tab *));
 	~Tab();
 	void active();
+	static bool canOpen();
 };
@@ -12,6 +12,7 @@
 	global AsmIntHandler04
 	global AsmIntHandler07
 	global AsmIntHandler0d
+	global AsmIntHandler0e
 	global AsmIntHandler20
 	global AsmIntHandler21, AsmIntHandler2c
 	global AsmIntHandler27
@@ -20,6 +21,7 @@
 	extern IntHandler04
 	extern IntHandler07
 	extern IntHandler0d
+	extern IntHandler0e
 	extern IntHandler20
 	extern IntHandler21, IntHandler2c
 
@@ -161,6 +163,14 @@ AsmIntHandler0d:
 	add		esp,4
 	IRETD
 
+AsmIntHandler0e:				; page fault (runs in its own TSS via task gate)
+	MOV		EAX,CR2
+	PUSH	EAX
+	CALL	IntHandler0e		; IntHandler0e(cr2, error code)
+	ADD		ESP,8
+	IRETD					; back to the faulting task
+	JMP		AsmIntHandler0e		; next fault resumes here
+
 AsmIntHandler20:
 	PUSH ES
 	PUSH DS
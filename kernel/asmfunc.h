@@ -18,6 +18,7 @@ extern "C" {
 	void AsmIntHandler04();
 	void AsmIntHandler07();
 	void AsmIntHandler0d();
+	void AsmIntHandler0e();
 	void AsmIntHandler20();
 	void AsmIntHandler21();
 	void AsmIntHandler27();
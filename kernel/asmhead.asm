@@ -9,6 +9,9 @@ VMODE	equ		0x0ff2			; 色数に関する情報。何ビットカラーか？
 SCRNX	equ		0x0ff4			; 解像度のX
 SCRNY	equ		0x0ff6			; 解像度のY
 VRAM	equ		0x0ff8			; グラフィックバッファの開始番地
+E820N	equ		0x0ffc			; メモリマップのエントリ数
+E820	equ		0x0b00			; メモリマップ (24バイト x 32個)
+E820MAX	equ		32
 
 [org 0xc200]					; このプログラムがどこに読み込まれるのか
 
@@ -105,6 +108,30 @@ keystatus:
 		push	dword [es:di+0x28]
 		pop		dword [VRAM]
 
+; BIOSからメモリマップ (E820) をもらう
+
+		mov		ax,0
+		mov		es,ax
+		mov		di,E820
+		mov		dword [E820N],0
+		xor		ebx,ebx			; 最初のエントリから
+e820_loop:
+		mov		eax,0x0000e820
+		mov		ecx,24
+		mov		edx,0x534d4150	; 'SMAP'
+		mov		dword [es:di+20],1	; ACPI 3.0 拡張属性を返さない BIOS のため
+		int		0x15
+		jc		e820_end		; 非対応か最後まで読んだ
+		cmp		eax,0x534d4150
+		jne		e820_end
+		inc		dword [E820N]
+		add		di,24
+		cmp		dword [E820N],E820MAX
+		jae		e820_end
+		test	ebx,ebx			; 0 なら最後のエントリ
+		jnz		e820_loop
+e820_end:
+
 ; キーボードのLED状態をBIOSに教えてもらう
 
 		mov		ah,0x02
@@ -6,6 +6,9 @@
 
 const int ADDRESS_BOOTINFO  = 0x00000ff0;
 const int ADDRESS_DISK_IMAGE = 0x00100000;
+const int ADDRESS_E820 = 0x00000b00;
+const int kE820Max = 32;
+const unsigned int kE820Usable = 1;
 
 struct BootInfo {
 	char  cyls;
@@ -15,4 +18,13 @@ struct BootInfo {
 	short scrnx;
 	short scrny;
 	unsigned char *vram;
+	int e820Count; // ADDRESS_E820 にあるメモリマップのエントリ数
+};
+
+// BIOS のメモリマップのエントリ (24バイト)
+struct E820Entry {
+	unsigned int baseLow, baseHigh;
+	unsigned int lengthLow, lengthHigh;
+	unsigned int type;
+	unsigned int attributes;
 };
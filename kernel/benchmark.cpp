@@ -0,0 +1,260 @@
+#include <stdio.h>
+#include <string.h>
+#include <HashMap.h>
+#include <Format.h>
+#include <MinMax.h>
+#include "../headers.h"
+#include "HTMLTokenizer.h"
+
+#ifdef BENCHMARK
+
+static inline unsigned long long readTsc() {
+	unsigned long long tsc;
+	asm volatile("rdtsc" : "=A"(tsc));
+	return tsc;
+}
+
+static void debugPrint(const char *s) {
+	for (; *s; ++s) {
+		Output8(kDebugPort, *s);
+	}
+}
+
+// 結果を捨てられないように
+static volatile int sink;
+
+/*
+ * HashMap と線形探索
+ * FAT12::search と同じく 11 文字のファイル名を strncmp で順に比べるのと，名前をキーにした HashMap を比べる
+ * (16: シートやタスクくらい，224: FAT12 のルートディレクトリの最大エントリ数)
+ */
+static void benchHashMap() {
+	const int kSizes[] = { 16, 64, 224 };
+	const int kRounds = 100;
+	static char names[224][11];
+	char s[80];
+	
+	for (int i = 0; i < 224; ++i) {
+		// "F0000123TXT" のような名前
+		memcpy(names[i], "F0000000TXT", 11);
+		for (int n = i, j = 7; n; n /= 10, --j) {
+			names[i][j] = '0' + n % 10;
+		}
+	}
+	
+	for (int size : kSizes) {
+		HashMap<string, int> map;
+		for (int i = 0; i < size; ++i) {
+			map.insert(string(names[i], 11), i);
+		}
+		
+		// 全部の名前を1回ずつ探す
+		unsigned long long start = readTsc();
+		for (int round = 0; round < kRounds; ++round) {
+			for (int i = 0; i < size; ++i) {
+				for (int j = 0; j < size; ++j) {
+					if (!strncmp(names[j], names[i], 11)) {
+						sink = j;
+						break;
+					}
+				}
+			}
+		}
+		unsigned int linear = (unsigned int)(readTsc() - start) / (kRounds * size);
+		
+		start = readTsc();
+		for (int round = 0; round < kRounds; ++round) {
+			for (int i = 0; i < size; ++i) {
+				sink = *map.find(string_view(names[i], 11));
+			}
+		}
+		unsigned int hash = (unsigned int)(readTsc() - start) / (kRounds * size);
+		
+		sprintf(s, "hashmap n=%u: linear %u, hash %u cycles/lookup\n", size, linear, hash);
+		debugPrint(s);
+	}
+}
+
+/*
+ * golibc の mem* と1バイトずつのループ
+ * 大きさとずれ (コピー先/コピー元のアドレスの下位2ビット) を変えて，どれも合計 1MB 分を処理する時間を測る
+ */
+// 比べる相手の1バイトずつのループ (gcc が memcpy の呼び出しに置き換えないように)
+__attribute__((optimize("no-tree-loop-distribute-patterns")))
+static void byteCopy(char *d, const char *s, unsigned int n) {
+	while (n--) *d++ = *s++;
+}
+__attribute__((optimize("no-tree-loop-distribute-patterns")))
+static void byteMoveBackward(char *d, const char *s, unsigned int n) {
+	while (n--) d[n] = s[n];
+}
+__attribute__((optimize("no-tree-loop-distribute-patterns")))
+static void byteSet(char *d, int c, unsigned int n) {
+	while (n--) *d++ = c;
+}
+__attribute__((optimize("no-tree-loop-distribute-patterns")))
+static void pixelSet(unsigned int *d, unsigned int v, unsigned int n) {
+	while (n--) *d++ = v;
+}
+__attribute__((optimize("no-tree-loop-distribute-patterns")))
+static unsigned int byteLength(const char *s) {
+	unsigned int n = 0;
+	while (s[n]) ++n;
+	return n;
+}
+
+static void benchMemory() {
+	const unsigned int kSizes[] = { 16, 256, 4096, 65536 };
+	const unsigned int kTotal = 1024 * 1024;
+	const int kAligns[][2] = { { 0, 0 }, { 1, 0 }, { 3, 1 } };
+	char *src = new char[65536 + 8];
+	char *dst = new char[65536 + 8];
+	char s[100];
+	
+	for (unsigned int i = 0; i < 65536 + 8; ++i) {
+		src[i] = 'a' + i % 26;
+	}
+	
+	// 1MB 分を処理した時間 (cycles/KB)
+	auto measure = [&](unsigned int size, auto &&f) {
+		unsigned long long start = readTsc();
+		for (unsigned int done = 0; done < kTotal; done += size) {
+			f();
+		}
+		return (unsigned int)(readTsc() - start) / (kTotal / 1024);
+	};
+	
+	for (unsigned int size : kSizes) {
+		for (auto &&align : kAligns) {
+			char *d = dst + align[0];
+			const char *p = src + align[1];
+			unsigned int byte = measure(size, [&] { byteCopy(d, p, size); });
+			unsigned int lib = measure(size, [&] { memcpy(d, p, size); });
+			sprintf(s, "memcpy size=%u align=%d/%d: byte %u, golibc %u cycles/KB\n", size, align[0], align[1], byte, lib);
+			debugPrint(s);
+		}
+		
+		// 重なっていて後ろからコピーする場合
+		memcpy(dst, src, size + 8);
+		unsigned int byte = measure(size, [&] { byteMoveBackward(dst + 4, dst, size); });
+		unsigned int lib = measure(size, [&] { memmove(dst + 4, dst, size); });
+		sprintf(s, "memmove size=%u overlap: byte %u, golibc %u cycles/KB\n", size, byte, lib);
+		debugPrint(s);
+		
+		byte = measure(size, [&] { byteSet(dst + 1, 0, size); });
+		lib = measure(size, [&] { memset(dst + 1, 0, size); });
+		sprintf(s, "memset size=%u: byte %u, golibc %u cycles/KB\n", size, byte, lib);
+		debugPrint(s);
+		
+		unsigned int *pixels = reinterpret_cast<unsigned int *>(dst);
+		byte = measure(size, [&] { pixelSet(pixels, 0x263238, size / 4); });
+		lib = measure(size, [&] { memset32(pixels, 0x263238, size / 4); });
+		sprintf(s, "memset32 size=%u: loop %u, golibc %u cycles/KB\n", size, byte, lib);
+		debugPrint(s);
+		
+		memcpy(dst, src, size);
+		dst[size - 1] = 0;
+		byte = measure(size, [&] { sink = byteLength(dst); });
+		lib = measure(size, [&] { sink = strlen(dst); });
+		sprintf(s, "strlen size=%u: byte %u, golibc %u cycles/KB\n", size, byte, lib);
+		debugPrint(s);
+	}
+	
+	delete[] src;
+	delete[] dst;
+}
+
+/*
+ * sprintf と format
+ * DateTimeMain の時計，showSysInfo のタスクの行 (sprintf してから string に足していたもの)，大きな数1つ
+ */
+static void benchFormat() {
+	const int kRounds = 1000;
+	char s[100], t[40];
+	string name = "sysinfo";
+	string str;
+	
+	// 1回あたりの時間 (cycles/call)
+	auto measure = [&](auto &&f) {
+		unsigned long long start = readTsc();
+		for (int round = 0; round < kRounds; ++round) {
+			f(round);
+		}
+		return (unsigned int)(readTsc() - start) / kRounds;
+	};
+	
+	unsigned int old = measure([&](int i) { sprintf(t, "%02d:%02d PM", i % 12, i % 60); });
+	unsigned int now = measure([&](int i) { format(t, "{:02}:{:02} PM"_fmt, i % 12, i % 60); });
+	format(s, "format clock: sprintf {}, format {} cycles/call\n"_fmt, old, now);
+	debugPrint(s);
+	
+	old = measure([&](int i) {
+		sprintf(t, "%5d %8d %4s %6u ", i % 4, i, i & 1 ? "(oo)" : "(__)", i * 3u);
+		str = t + name;
+	});
+	now = measure([&](int i) {
+		str = "";
+		format(str, "{:5} {:8} {:4} {:6} {}"_fmt, i % 4, i, i & 1 ? "(oo)" : "(__)", i * 3u, name);
+	});
+	format(s, "format task row: sprintf+string {}, format {} cycles/call\n"_fmt, old, now);
+	debugPrint(s);
+	
+	old = measure([&](int i) { sprintf(t, "%u", 4000000000u - i); });
+	now = measure([&](int i) { format(t, "{}"_fmt, 4000000000u - i); });
+	format(s, "format 10 digits: sprintf {}, format {} cycles/call\n"_fmt, old, now);
+	debugPrint(s);
+	sink = t[0];
+}
+
+/*
+ * HTML のトークナイザ
+ * kitai.htm と，段落・リンク・コメントを繰り返した 2MB の HTML から，next() でトークンを全部取り出す時間
+ */
+static unsigned int tokenize(string_view input) {
+	unsigned long long start = readTsc();
+	HTML::Tokenizer tokenizer;
+	tokenizer.feed(input);
+	tokenizer.finish();
+	int count = 0;
+	while (tokenizer.next()) ++count;
+	unsigned int cycles = (unsigned int)(readTsc() - start);
+	sink = count;
+	
+	// cycles/KB
+	unsigned int kb = input.length() / 1024;
+	return cycles / (kb ? kb : 1);
+}
+
+static void benchTokenizer() {
+	const char kParagraph[] =
+		"<p class=\"text\">The quick brown fox jumps over the lazy dog. "
+		"Pack my box with five dozen liquor jugs, <a href=\"next.htm\">then go on</a> to the next page.</p>\n"
+		"<!-- The comment is long enough to be worth skipping over in one go -->\n";
+	const unsigned int kSize = 2 * 1024 * 1024;
+	char s[80];
+	
+	File file("kitai.htm");
+	if (file.open()) {
+		string_view source(reinterpret_cast<const char *>(file.read().get()), file.size);
+		format(s, "tokenizer kitai.htm ({} bytes): {} cycles/KB\n"_fmt, source.length(), tokenize(source));
+		debugPrint(s);
+	}
+	
+	char *synthetic = new char[kSize];
+	for (unsigned int i = 0; i < kSize; i += sizeof kParagraph - 1) {
+		memcpy(synthetic + i, kParagraph, min<unsigned int>(sizeof kParagraph - 1, kSize - i));
+	}
+	format(s, "tokenizer synthetic ({} bytes): {} cycles/KB\n"_fmt, kSize, tokenize(string_view(synthetic, kSize)));
+	debugPrint(s);
+	delete[] synthetic;
+}
+
+void RunBenchmarks() {
+	debugPrint("# benchmark\n");
+	benchHashMap();
+	benchMemory();
+	benchFormat();
+	benchTokenizer();
+}
+
+#endif
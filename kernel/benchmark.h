@@ -0,0 +1,12 @@
+/*
+ * マイクロベンチマーク (make BENCHMARK=1 のときだけ有効)
+ */
+
+#pragma once
+
+#ifdef BENCHMARK
+
+// 起動時に全部測ってデバッグポートに書き出す (他のタスクが動き出す前に呼ぶ)
+void RunBenchmarks();
+
+#endif
@@ -1,5 +1,5 @@
 #include "../headers.h"
-#include <stdio.h>
+#include <Format.h>
 
 void DateTimeMain() {
 	Task *task = TaskSwitcher::getNowTask();
@@ -37,40 +37,20 @@ void DateTimeMain() {
 	Sheet dateTimeSheet(Size(8 * 8, 16), true);
 	dateTimeSheet.fillRect(dateTimeSheet.frame, kTransColor);
 	if (now[2] >= 12) {
-		sprintf(s, "%02d:%02d PM", now[2] - 12, now[1]);
+		format(s, "{:02}:{:02} PM"_fmt, now[2] - 12, now[1]);
 	} else {
-		sprintf(s, "%02d:%02d AM", now[2], now[1]);
+		format(s, "{:02}:{:02} AM"_fmt, now[2], now[1]);
 	}
 	dateTimeSheet.drawString(s, Point(0, 0), 0xffffff);
 	dateTimeSheet.moveTo(Point(2, SheetCtl::resolution.height - 18));
 	dateTimeSheet.upDown(SheetCtl::top);
 	
+	int data[8];
 	for (;;) {
-		Cli();
-		if (task->queue->isempty()) {
-			// 解像度が変更されていたら位置を修正
-			if (dateTimeSheet.frame.offset.y != SheetCtl::resolution.height - 18) {
-				dateTimeSheet.moveTo(Point(2, SheetCtl::resolution.height - 18));
-			}
-			if (timechk) {
-				Sti();
-				if (now[2] >= 12) {
-					sprintf(s, "%02d:%02d PM", now[2] - 12, now[1]);
-				} else {
-					sprintf(s, "%02d:%02d AM", now[2], now[1]);
-				}
-				dateTimeSheet.fillRect(Rectangle(Point(0, 0), dateTimeSheet.frame.size), kTransColor);
-				dateTimeSheet.drawString(s, Point(0, 0), 0xffffff);
-				dateTimeSheet.refresh(Rectangle(Point(0, 0), dateTimeSheet.frame.size));
-				timechk = false;
-			} else {
-				task->sleep();
-				Sti();
-			}
-		} else {
-			int data = task->queue->pop();
-			Sti();
-			if (data == timer->data) { // 番号が合っているか確認
+		// 届いている分をまとめて取り出す (割り込みは止めない)
+		int n = task->queue->pop_n(data, 8);
+		for (int i = 0; i < n; ++i) {
+			if (data[i] == timer->data) { // 番号が合っているか確認
 				timer->set(100);
 				++now[0]; // second
 				if (now[0] >= 60) {
@@ -89,5 +69,29 @@ void DateTimeMain() {
 				}
 			}
 		}
+		if (n) continue;
+		
+		// 解像度が変更されていたら位置を修正
+		if (dateTimeSheet.frame.offset.y != SheetCtl::resolution.height - 18) {
+			dateTimeSheet.moveTo(Point(2, SheetCtl::resolution.height - 18));
+		}
+		if (timechk) {
+			if (now[2] >= 12) {
+				format(s, "{:02}:{:02} PM"_fmt, now[2] - 12, now[1]);
+			} else {
+				format(s, "{:02}:{:02} AM"_fmt, now[2], now[1]);
+			}
+			dateTimeSheet.fillRect(Rectangle(Point(0, 0), dateTimeSheet.frame.size), kTransColor);
+			dateTimeSheet.drawString(s, Point(0, 0), 0xffffff);
+			dateTimeSheet.refresh(Rectangle(Point(0, 0), dateTimeSheet.frame.size));
+			timechk = false;
+		} else {
+			// 眠るかどうかを決める間だけ割り込みを止める (確かめてから眠るまでに届いたものを取りこぼさないように)
+			Cli();
+			if (task->queue->isempty()) {
+				task->sleep();
+			}
+			Sti();
+		}
 	}
 }
@@ -12,6 +12,7 @@ const int kArCode32Er = 0x409a;
 const int kArLdt = 0x0082;
 const int kArTss32 = 0x0089;
 const int kArIntGate32 = 0x008e;
+const int kArTaskGate = 0x0085;
 
 struct SegmentDescriptor {
 	short limit_low, base_low;
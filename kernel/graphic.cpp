@@ -1,3 +1,4 @@
+#include <string.h>
 #include <SmartPointer.h>
 #include <MinMax.h>
 #include "../headers.h"
@@ -7,63 +8,57 @@
 Sheet::Sheet(const Size &size, bool _nonRect) :
 	_frame(size),
 	nonRect(_nonRect),
-	buf(new unsigned int[size.getArea()]) {}
+	buf(reinterpret_cast<unsigned int *>(ReserveMemory(size.getArea() * sizeof(unsigned int)))) {
+	if (!buf) OutOfMemory();
+}
 
 Sheet::~Sheet() {
 	if (zIndex >= 0) upDown(-1);
 	if (onClosed) onClosed();
-	delete[] buf;
+	ReleaseMemory(buf);
 }
 
 // シートの高さを変更
 void Sheet::upDown(int z) {
 	int old = _zIndex;
 
-	if (z > SheetCtl::top + 1) z = SheetCtl::top + 1;
+	// 表示中のシートは top まで，非表示のシートは top + 1 (一番上) まで
+	int highest = old < 0 ? SheetCtl::top + 1 : SheetCtl::top;
+	if (z > highest) z = highest;
 	if (z < -1) z = -1;
+	if (z == old) return;
+	// map は高さを1バイトで持つので，それを超えたら無視
+	if (old < 0 && SheetCtl::top + 1 >= kMaxSheets) return;
+
+	// 外して z 番目のシートの前に入れ直す (配列をずらさない)
+	if (old >= 0) {
+		SheetCtl::sheets.remove(*this);
+		--SheetCtl::_top;
+	}
+	if (z >= 0) {
+		SheetCtl::sheets.insert(SheetCtl::sheetAt(z), *this);
+		++SheetCtl::_top;
+	}
 	_zIndex = z;
 
+	// 間にあったシートの高さを付け直す
+	int h0 = old < 0 ? z : z < 0 ? old : min(old, z);
+	int h1 = old < 0 || z < 0 ? SheetCtl::top : max(old, z);
+	Sheet *sht = SheetCtl::sheetAt(h0);
+	for (int h = h0; sht && h <= h1; ++h, sht = SheetCtl::sheets.next(*sht)) {
+		sht->_zIndex = h;
+	}
+
 	if (old > z) { // 前より低くなった
 		if (z >= 0) { // 表示
-			for (int h = old; h > z; --h) {
-				SheetCtl::sheets[h] = SheetCtl::sheets[h - 1];
-				SheetCtl::sheets[h]->_zIndex = h;
-			}
-			SheetCtl::sheets[z] = this;
 			SheetCtl::refreshMap(frame, z + 1);
-			SheetCtl::refreshSub(frame);
 		} else { // 非表示
-			if (SheetCtl::top > old) {
-				for (int h = old; h < SheetCtl::top; ++h) {
-					SheetCtl::sheets[h] = SheetCtl::sheets[h + 1];
-					SheetCtl::sheets[h]->_zIndex = h;
-				}
-			}
-			--SheetCtl::_top;
 			SheetCtl::refreshMap(frame, 0);
-			SheetCtl::refreshSub(frame);
-		}
-	} else if (old < z) { // 以前より高くなった
-		if (old >= 0) {	// より高く
-			for (int h = old; h < z; ++h) {
-				SheetCtl::sheets[h] = SheetCtl::sheets[h + 1];
-				SheetCtl::sheets[h]->_zIndex = h;
-			}
-			SheetCtl::sheets[z] = this;
-		} else { // 非表示から表示へ
-			// 管理配列の限界が来たら無視
-			if (SheetCtl::top + 1 >= kMaxSheets) return;
-			
-			for (int h = SheetCtl::top; h >= z; --h) {
-				SheetCtl::sheets[h + 1] = SheetCtl::sheets[h];
-				SheetCtl::sheets[h + 1]->_zIndex = h + 1;
-			}
-			SheetCtl::sheets[z] = this;
-			++SheetCtl::_top;
 		}
+	} else { // 以前より高くなった
 		SheetCtl::refreshMap(frame, z);
-		SheetCtl::refreshSub(frame);
 	}
+	SheetCtl::refreshSub(frame);
 }
 
 // シートのリフレッシュ
@@ -93,8 +88,8 @@ void Sheet::drawLine(const Line &line, unsigned int color) {
 
 	// 縦横の直線高速化
 	if (line.start.y == line.end.y) {
-		for (x = line.start.x; x <= line.end.x; ++x) {
-			buf[line.start.y * frame.size.width + x] = color;
+		if (line.start.x <= line.end.x) {
+			memset32(&buf[line.start.y * frame.size.width + line.start.x], color, line.end.x - line.start.x + 1);
 		}
 		return;
 	} else if (line.start.x == line.end.x) {
@@ -181,11 +176,11 @@ void Sheet::gradLine(const Line &line, unsigned int col0, unsigned int col1, Gra
 // 枠のみ長方形を描画
 void Sheet::drawRect(const Rectangle &rect, unsigned int color) {
 	int endy = rect.getEndPoint().y - 1;
-	for (int x = 0; x < rect.size.width; ++x) {
+	if (rect.size.width > 0) {
 		// 上の辺を描画
-		buf[rect.offset.y * frame.size.width + x + rect.offset.x] = color;
+		memset32(&buf[rect.offset.y * frame.size.width + rect.offset.x], color, rect.size.width);
 		// 下の辺を描画
-		buf[endy * frame.size.width + x + rect.offset.x] = color;
+		memset32(&buf[endy * frame.size.width + rect.offset.x], color, rect.size.width);
 	}
 	int endx = rect.getEndPoint().x - 1;
 	for (int y = 1; y < rect.size.height - 1; ++y) {
@@ -198,11 +193,9 @@ void Sheet::drawRect(const Rectangle &rect, unsigned int color) {
 
 // 塗りつぶし長方形を描画
 void Sheet::fillRect(const Rectangle &rect, unsigned int color) {
+	if (rect.size.width <= 0) return;
 	for (int y = 0; y < rect.size.height; ++y) {
-		int by = y + rect.offset.y;
-		for (int x = 0; x < rect.size.width; ++x) {
-			buf[by * frame.size.width + x + rect.offset.x] = color;
-		}
+		memset32(&buf[(y + rect.offset.y) * frame.size.width + rect.offset.x], color, rect.size.width);
 	}
 }
 
@@ -216,11 +209,10 @@ void Sheet::gradRect(const Rectangle &rect, unsigned int col0, unsigned int col1
 			}
 		}
 	} else if (direction == GradientDirection::TopToBottom) { //縦
+		if (rect.size.width <= 0) return;
 		for (int y = 0; y < rect.size.height; ++y) {
 			unsigned int gradColor = GetGrad(0, rect.size.height - 1, y, col0, col1);
-			for (int x = 0; x < rect.size.width; ++x) {
-				buf[(y + rect.offset.y) * frame.size.width + x + rect.offset.x] = gradColor;
-			}
+			memset32(&buf[(y + rect.offset.y) * frame.size.width + rect.offset.x], gradColor, rect.size.width);
 		}
 	}
 }
@@ -291,14 +283,10 @@ void Sheet::fillCircle(const Circle &cir, unsigned int color) {
 		}
 	} else {*/
 		while (x >= y) {
-			for (int xx = cir.center.x - x; xx < cir.center.x + x; ++xx) {
-				buf[(cir.center.y + y) * frame.size.width + xx] = color;
-				buf[(cir.center.y - y) * frame.size.width + xx] = color;
-			}
-			for (int xx = cir.center.x - y; xx < cir.center.x + y; ++xx) {
-				buf[(cir.center.y + x - 1) * frame.size.width + xx] = color;
-				buf[(cir.center.y - x) * frame.size.width + xx] = color;
-			}
+			memset32(&buf[(cir.center.y + y) * frame.size.width + cir.center.x - x], color, 2 * x);
+			memset32(&buf[(cir.center.y - y) * frame.size.width + cir.center.x - x], color, 2 * x);
+			memset32(&buf[(cir.center.y + x - 1) * frame.size.width + cir.center.x - y], color, 2 * y);
+			memset32(&buf[(cir.center.y - x) * frame.size.width + cir.center.x - y], color, 2 * y);
 			if (F >= 0) {
 				--x;
 				F -= 4 * x;
@@ -535,9 +523,11 @@ Sheet *SheetCtl::contextMenu;
 Tab *SheetCtl::tabs[kMaxTabs];
 int SheetCtl::numOfTab = 0;
 int SheetCtl::activeTab = -1;
-Sheet *SheetCtl::sheets[kMaxSheets];
+IntrusiveList<Sheet, &Sheet::zHook> SheetCtl::sheets;
 int SheetCtl::color;
 const int &SheetCtl::colorDepth = color;
+unsigned int SheetCtl::_fillRate[2];
+const unsigned int (&SheetCtl::fillRate)[2] = _fillRate;
 File *SheetCtl::font;
 Point SheetCtl::mouseCursorPos(-1, 0);
 Sheet *SheetCtl::mouseCursorSheet;
@@ -560,13 +550,29 @@ const char *SheetCtl::mouseCursor[] = {
 	"*****OOOOOO*****"
 };
 
-void rPrintNode(shared_ptr<HTML::Node> &pnode, Sheet &sht, int &i, int x0) {
+void rPrintNode(intrusive_ptr<HTML::Node> &pnode, Sheet &sht, int &i, int x0) {
 	sht.drawString(pnode->getData(), Point(1 + x0, 17 + i++ * 16), 0);
 	for (auto &&node : pnode->children) {
 		rPrintNode(node, sht, i, x0 + 8);
 	}
 }
 
+// VRAM を kFillRateTicks の間塗り続けて，書き込める速さ (MB/s) を返す
+static unsigned int measureFillRate(unsigned int *vram, unsigned int words) {
+	TaskQueue queue(4, nullptr);
+	Timer timer(&queue);
+	unsigned int bytes = 0;
+	timer.set(kFillRateTicks);
+	while (queue.isempty()) {
+		for (unsigned int i = 0; i < words; ++i) {
+			vram[i] = 0;
+		}
+		bytes += words * 4;
+		asm volatile("" : : : "memory"); // queue はタイマー割り込みで書き換わる
+	}
+	return bytes / kFillRateTicks / 10000;
+}
+
 // シートコントロールを初期化
 void SheetCtl::init() {
 	/* データメンバ初期化 */
@@ -581,6 +587,13 @@ void SheetCtl::init() {
 	color = 32;
 	vram.p16 = reinterpret_cast<unsigned short *>(0xe0000000);
 	
+	// 既定のキャッシュ設定と WC で塗りつぶしの速さを比べてから，WC で使う
+	unsigned int vramSize = resolution.getArea() * color / 8;
+	MapIdentity(reinterpret_cast<unsigned int>(vram.p16), vramSize);
+	_fillRate[0] = measureFillRate(vram.p32, vramSize / 4);
+	MapIdentity(reinterpret_cast<unsigned int>(vram.p16), vramSize, kPteWriteCombining);
+	_fillRate[1] = measureFillRate(vram.p32, vramSize / 4);
+	
 	map         = new unsigned char[resolution.getArea()];
 	tboxString  = new string();
 
@@ -676,14 +689,22 @@ void SheetCtl::guiTaskMain() {
 	caretTimer = new Timer(queue, 0x80);
 	caretTimer->set(50);
 	
+	int received[16], count = 0, next = 0;
 	for (;;) {
-		Cli();
-		if (task.queue->isempty()) {
-			task.sleep();
+		if (next == count) {
+			// 届いている分をまとめて取り出す (割り込みは止めない)
+			count = task.queue->pop_n(received, 16);
+			next = 0;
+		}
+		if (!count) {
+			// 眠るかどうかを決める間だけ割り込みを止める
+			Cli();
+			if (task.queue->isempty()) {
+				task.sleep();
+			}
 			Sti();
 		} else {
-			int data = task.queue->pop();
-			Sti();
+			int data = received[next++];
 			if (data < 0x80) {
 				// from Keyboard Driver
 				switch (data) {
@@ -711,6 +732,8 @@ void SheetCtl::guiTaskMain() {
 					
 					case 0x0a: { // LF
 						if (tboxString->length() == 0) break;
+						// 新しいタブのシートが確保できないなら開かない
+						if (!Tab::canOpen()) break;
 						
 						string url = *tboxString;
 						
@@ -753,17 +776,17 @@ void SheetCtl::guiTaskMain() {
 								Sheet &sht = *tab->sheet;
 								url.erase(0, 8); // "file:///" の削除
 								unique_ptr<File> htmlFile(new File(url));
-								if (htmlFile->open()) {
-									// ソースの取得
-									string source(reinterpret_cast<char *>(htmlFile->read().get()), htmlFile->size);
-									
-									// トークン化
-									HTML::Tokenizer tokenizer;
-									Queue<shared_ptr<HTML::Token>> &tokens = tokenizer.tokenize(source);
-									
-									// ツリー構築
-									HTML::TreeConstructor constructor;
-									HTML::Document &document = constructor.construct(tokens);
+								HTML::Tokenizer tokenizer;
+								HTML::TreeConstructor constructor;
+								// 読めた分ずつトークン化してツリー構築 (トークンは1つずつ取り出すので溜まらない)
+								// トークンはディスクイメージか htmlFile のバッファを指すので，htmlFile はツリー構築が終わるまで残す
+								bool found = htmlFile->readChunks([&](string_view chunk) {
+									tokenizer.feed(chunk);
+									constructor.construct(tokenizer);
+								});
+								if (found) {
+									tokenizer.finish();
+									HTML::Document &document = constructor.construct(tokenizer);
 									
 									// レンダリング
 									sht.drawString("パース結果", Point(1, 1), 0);
@@ -845,8 +868,8 @@ void SheetCtl::guiTaskMain() {
 						}
 						
 						// 各シートの onClick イベントを発動
-						for (int i = top - 1; i >= 0; --i) {
-							Sheet &sht = *sheets[i];
+						for (Sheet *p = sheetAt(top - 1); p; p = sheets.prev(*p)) {
+							Sheet &sht = *p;
 							if (sht.onClick && sht.frame.contains(mouseCursorPos)) {
 								sht.onClick(mouseCursorPos, sht);
 								break;
@@ -923,13 +946,28 @@ void SheetCtl::onClickBack(const Point &pos, Sheet &sht) {
 	}
 }
 
+// 高さ z のシート (無ければ nullptr)．近いほうの端からたどる
+Sheet *SheetCtl::sheetAt(int z) {
+	if (z < 0 || z > top) return nullptr;
+	Sheet *sht;
+	if (z <= top / 2) {
+		sht = sheets.front();
+		for (int h = 0; h < z; ++h) sht = sheets.next(*sht);
+	} else {
+		sht = sheets.back();
+		for (int h = top; h > z; --h) sht = sheets.prev(*sht);
+	}
+	return sht;
+}
+
 // 指定範囲の変更をmapに適用
 void SheetCtl::refreshMap(const Rectangle &range, int h0) {
 	int bx0, by0, bx1, by1, sid4;
 	int vx0 = max(0, range.offset.x), vy0 = max(0, range.offset.y);
 	int vx1 = min(resolution.width, range.getEndPoint().x), vy1 = min(resolution.height, range.getEndPoint().y);
-	for (int sid = h0; sid <= top; ++sid) {
-		const Sheet &sht = *sheets[sid];
+	for (const Sheet *p = sheetAt(h0); p; p = sheets.next(*p)) {
+		const Sheet &sht = *p;
+		int sid = sht.zIndex;
 		bx0 = max(0, vx0 - sht.frame.offset.x);
 		by0 = max(0, vy0 - sht.frame.offset.y);
 		bx1 = min(sht.frame.size.width, vx1 - sht.frame.offset.x);
@@ -974,8 +1012,8 @@ void SheetCtl::refreshSub(const Rectangle &range) {
 	int vx1 = min(resolution.width, range.getEndPoint().x), vy1 = min(resolution.height, range.getEndPoint().y);
 	unique_ptr<unsigned int> backrgb(new unsigned int[(vx1 - vx0) * (vy1 - vy0)]);
 
-	for (int sid = 0; sid <= top; ++sid) {
-		const Sheet &sht = *sheets[sid];
+	for (auto &&sht : sheets) {
+		int sid = sht.zIndex;
 		/* vx0～vy1を使って、bx0～by1を逆算する */
 		bx0 = max(0, vx0 - sht.frame.offset.x);
 		by0 = max(0, vy0 - sht.frame.offset.y);
@@ -5,9 +5,11 @@
 #pragma once
 
 #include <pistring.h>
+#include <IntrusiveList.h>
 
 const int kMaxSheets = 256;
 const int kMaxTabs = 100;
+const unsigned int kFillRateTicks = 10; // VRAM の速さを測る時間 (10ms 単位)
 
 enum class GradientDirection { LeftToRight, TopToBottom };
 enum class Encoding { SJIS, UTF8, EUCJP };
@@ -95,6 +97,7 @@ private:
 	Rectangle _frame = Rectangle(0, 0);
 	int _zIndex = -1;
 	bool nonRect;
+	ListHook<Sheet> zHook; // SheetCtl::sheets のつなぎ
 
 public:
 	unsigned int *buf;
@@ -140,10 +143,11 @@ private:
 	} vram;
 	static unsigned char *map;
 	static File *font;
-	static Sheet *sheets[];
+	static IntrusiveList<Sheet, &Sheet::zHook> sheets; // 下から順
 	static Size _resolution;
 	static int color;
 	static int _top;
+	static unsigned int _fillRate[2];
 	
 	// for GUI Task
 	static Sheet *back;
@@ -164,11 +168,13 @@ private:
 	static void onClickBack(const Point &pos, Sheet &sht);
 	static void refreshMap(const Rectangle &range, int);
 	static void refreshSub(const Rectangle &range);
+	static Sheet *sheetAt(int z);
 
 public:
 	static const int &top;
 	static const Size &resolution;
 	static const int &colorDepth;
+	static const unsigned int (&fillRate)[2]; // 画面全体を塗る速さ (MB/s): 既定のキャッシュ設定, WC
 	
 	// for GUI Task
 	static TaskQueue *queue;
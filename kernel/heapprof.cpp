@@ -0,0 +1,155 @@
+#include <Format.h>
+#include "../headers.h"
+
+#ifdef HEAP_PROFILE
+
+// 確保した領域の先頭に置く記録
+struct ProfileHeader {
+	unsigned short site; // sites の番号
+	unsigned short task; // tasks の番号
+	unsigned int size;   // 要求されたサイズ
+};
+
+static HeapSite sites[kHeapSites];
+static HeapTaskUsage tasks[kHeapTasks];
+static HeapEvent events[kHeapEvents];
+static unsigned int eventCount;  // これまでの記録の数
+static unsigned int dumpedCount; // デバッグポートに書き出した記録の数
+
+// 呼び出し元の番号 (開番地法，いっぱいなら最後の番号にまとめる)
+static int siteIndex(unsigned int caller) {
+	unsigned int i = (caller >> 2) % kHeapSites;
+	for (int n = 0; n < kHeapSites; ++n, i = (i + 1) % kHeapSites) {
+		if (sites[i].caller == caller) return i;
+		if (!sites[i].caller) {
+			sites[i].caller = caller;
+			return i;
+		}
+	}
+	return kHeapSites - 1;
+}
+
+// タスクの番号 (何も持っていない番号は使い回す，いっぱいなら最後の番号にまとめる)
+static int taskIndex(Task *task) {
+	int empty = -1;
+	for (int i = 0; i < kHeapTasks; ++i) {
+		if (tasks[i].task == task) return i;
+		if (!tasks[i].count && empty < 0) empty = i;
+	}
+	if (empty < 0) return kHeapTasks - 1;
+	tasks[empty].task = task;
+	tasks[empty].bytes = 0;
+	return empty;
+}
+
+static void record(unsigned int caller, int size, Task *task) {
+	HeapEvent &event = events[eventCount % kHeapEvents];
+	event.caller = caller;
+	event.size = size;
+	event.task = task;
+	++eventCount;
+}
+
+// addr は kProfileHeader バイト多く確保した領域．記録して呼び出し元に返すアドレスを返す
+void *ProfileAlloc(void *addr, unsigned int size, unsigned int caller) {
+	int e = LoadEflags();
+	Cli();
+	Task *task = TaskSwitcher::getNowTask();
+	ProfileHeader *header = (ProfileHeader *)addr;
+	header->site = siteIndex(caller);
+	header->task = taskIndex(task);
+	header->size = size;
+	sites[header->site].bytes += size;
+	++sites[header->site].count;
+	tasks[header->task].bytes += size;
+	++tasks[header->task].count;
+	record(caller, size, task);
+	StoreEflags(e);
+	return header + 1;
+}
+
+// 記録を消して本当の先頭アドレスを返す (確保したタスクではなく確保した呼び出し元に付ける)
+void *ProfileFree(void *addr) {
+	int e = LoadEflags();
+	Cli();
+	ProfileHeader *header = (ProfileHeader *)addr - 1;
+	HeapSite &site = sites[header->site];
+	HeapTaskUsage &usage = tasks[header->task];
+	site.bytes -= header->size;
+	--site.count;
+	usage.bytes -= header->size;
+	--usage.count;
+	record(site.caller, -(int)header->size, usage.task);
+	StoreEflags(e);
+	return header;
+}
+
+// 使用中のバイト数の多い順に max 個
+int HeapProfileSites(HeapSite *out, int max) {
+	int n = 0;
+	int e = LoadEflags();
+	Cli();
+	for (int i = 0; i < kHeapSites; ++i) {
+		if (!sites[i].bytes) continue;
+		if (n < max) {
+			++n;
+		} else if (out[n - 1].bytes >= sites[i].bytes) {
+			continue;
+		}
+		int j = n - 1;
+		for (; j > 0 && out[j - 1].bytes < sites[i].bytes; --j) {
+			out[j] = out[j - 1];
+		}
+		out[j] = sites[i];
+	}
+	StoreEflags(e);
+	return n;
+}
+
+int HeapProfileTasks(HeapTaskUsage *out, int max) {
+	int n = 0;
+	int e = LoadEflags();
+	Cli();
+	for (int i = 0; i < kHeapTasks && n < max; ++i) {
+		if (tasks[i].count) out[n++] = tasks[i];
+	}
+	StoreEflags(e);
+	return n;
+}
+
+static void debugPrint(const char *s) {
+	for (; *s; ++s) {
+		Output8(kDebugPort, *s);
+	}
+}
+
+// 前回から増えた記録をデバッグポートに書き出す (kernel.map と突き合わせて呼び出し元を調べる)
+// 形式: "+ 呼び出し元 サイズ タスク" (確保) / "- 呼び出し元 サイズ タスク" (解放)
+void HeapProfileDump() {
+	char s[40];
+	for (;;) {
+		// 1件ずつ取り出して，書き出している間は割り込みを止めない
+		int e = LoadEflags();
+		Cli();
+		if (dumpedCount == eventCount) {
+			StoreEflags(e);
+			break;
+		}
+		if (eventCount - dumpedCount > (unsigned int)kHeapEvents) {
+			unsigned int lost = eventCount - dumpedCount - kHeapEvents;
+			dumpedCount = eventCount - kHeapEvents;
+			StoreEflags(e);
+			format(s, "# lost {}\n"_fmt, lost);
+			debugPrint(s);
+			continue;
+		}
+		HeapEvent event = events[dumpedCount % kHeapEvents];
+		++dumpedCount;
+		StoreEflags(e);
+		
+		format(s, "{} {:08x} {} {:08x}\n"_fmt, event.size < 0 ? '-' : '+', event.caller, event.size < 0 ? -event.size : event.size, (unsigned int)event.task);
+		debugPrint(s);
+	}
+}
+
+#endif
@@ -0,0 +1,43 @@
+/*
+ * ヒーププロファイラ (make HEAP_PROFILE=1 のときだけ有効)
+ */
+
+#pragma once
+
+const int kDebugPort = 0x00e9; // QEMU の -debugcon
+
+#ifdef HEAP_PROFILE
+
+class Task;
+
+const unsigned int kProfileHeader = 8; // 確保した領域の先頭に置く記録
+const int kHeapSites = 512;            // 記録できる呼び出し元の数
+const int kHeapTasks = 64;             // 記録できるタスクの数
+const int kHeapEvents = 4096;          // 確保・解放の記録のリングの大きさ
+
+// 呼び出し元ごとの使用中のメモリ
+struct HeapSite {
+	unsigned int caller;
+	unsigned int bytes, count;
+};
+
+// タスクごとの使用中のメモリ
+struct HeapTaskUsage {
+	Task *task;
+	unsigned int bytes, count;
+};
+
+// 確保・解放の記録 (size が負なら解放)
+struct HeapEvent {
+	unsigned int caller;
+	int size;
+	Task *task;
+};
+
+void *ProfileAlloc(void *addr, unsigned int size, unsigned int caller);
+void *ProfileFree(void *addr);
+int  HeapProfileSites(HeapSite *out, int max);
+int  HeapProfileTasks(HeapTaskUsage *out, int max);
+void HeapProfileDump();
+
+#endif
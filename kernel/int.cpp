@@ -58,6 +58,18 @@ int IntHandler0d(int *esp) {
 	return 1;
 }
 
+// ページフォルト (専用のタスクで動くので，あふれたスタックは使わない)
+void IntHandler0e(unsigned int addr, int errorCode) {
+	const char *reason = HandlePageFault(addr);
+	if (reason) {
+		// 直せないので止める
+		SheetCtl::blueScreen(reason);
+		for (;;) {
+			Hlt();
+		}
+	}
+}
+
 // PIT割り込み
 void IntHandler20(int *esp) {
 	Timer *timer;
@@ -73,8 +85,8 @@ void IntHandler20(int *esp) {
 	if (TimerController::next > TimerController::count) return;
 	
 	// タイムアウト処理
-	timer = TimerController::t0;
-	while (timer->timeout <= TimerController::count) {
+	while ((timer = TimerController::timers.front())->timeout <= TimerController::count) {
+		TimerController::timers.remove(*timer);
 		timer->running = false;
 		if (timer != TaskSwitcher::timer) {
 			// 一般タイマーのタイムアウト
@@ -83,11 +95,9 @@ void IntHandler20(int *esp) {
 			// タスクスイッチ用タイマーのタイムアウト
 			ts = true;
 		}
-		timer = timer->next;
 	}
 	
 	// 次のタイムアウトのための準備
-	TimerController::t0 = timer;
 	TimerController::next = timer->timeout;
 	
 	// タスクスイッチ
@@ -20,6 +20,7 @@ extern "C" {
 	int  IntHandler04(int *);
 	void IntHandler07(int *);
 	int  IntHandler0d(int *);
+	void IntHandler0e(unsigned int addr, int errorCode);
 	void IntHandler20(int *);
 	void IntHandler21(int *);
 	void IntHandler2c(int *);
@@ -8,6 +8,7 @@ int main() {
 	/* 初期化 */
 	MemoryInit();
 	DescriptorInit();
+	PagingInit();
 	PICInit();
 	FAT12::init();
 	TimerController::init();
@@ -17,6 +18,11 @@ int main() {
 	Output8(kPic1Imr, 0xef); /* マウスを許可(11101111) */
 	Sti();
 	
+#ifdef BENCHMARK
+	// 他のタスクが動き出す前に測る (結果はデバッグポートへ)
+	RunBenchmarks();
+#endif
+	
 	// タスクの起動
 	SheetCtl::init();
 	new Task("日付と時刻タスク", 2, 1, 128, &DateTimeMain);
@@ -29,21 +35,26 @@ int main() {
 		
 		bool refreshRequired = false;
 		
+		int data[8];
 		for (;;) {
+			// 届いている分をまとめて取り出す (割り込みは止めない)
+			int n = task->queue->pop_n(data, 8);
+			for (int i = 0; i < n; ++i) {
+				browser->Scroll(data[i]);
+				refreshRequired = true;
+			}
+			if (n) continue;
+			
+			if (refreshRequired) {
+				SheetCtl::refresh(*SheetCtl::window_[0], 1, 1, SheetCtl::window_[0]->bxsize - 2, SheetCtl::window_[0]->bysize - 1);
+				refreshRequired = false;
+			}
+			// 眠るかどうかを決める間だけ割り込みを止める
 			Cli();
-			if (task->queue_->isempty()) {
-				if (refreshRequired) {
-					SheetCtl::refresh(*SheetCtl::window_[0], 1, 1, SheetCtl::window_[0]->bxsize - 2, SheetCtl::window_[0]->bysize - 1);
-					refreshRequired = false;
-				}
+			if (task->queue->isempty()) {
 				task->sleep();
-				Sti();
-			} else {
-				int data = task->queue_->pop();
-				Sti();
-				browser->Scroll(data);
-				refreshRequired = true;
 			}
+			Sti();
 		}
 	});*/
 
@@ -1,24 +1,115 @@
 #include "../headers.h"
 
-bool free0(void *addr, unsigned int size);
+static void heapAddRegion(unsigned int start, unsigned int end);
+static void buddyInit(unsigned int table, unsigned int end);
+static void buddyAddRegion(unsigned int start, unsigned int end);
+static bool usableRange(const E820Entry &entry, unsigned int &start, unsigned int &end);
+static void arenaInit(Arena *arena);
+static unsigned int shrinkSlabs(unsigned int bytes);
+static unsigned int shrinkPools(unsigned int bytes);
+static bool shrinkMemory(unsigned int bytes);
+static void checkWatermarks();
+[[noreturn]] static void halt(const char *reason);
+static Arena *currentArena();
+
+// スラブのサイズクラス (ヘッダを除いた 4064 バイトをなるべく余りなく割り切れるように選ぶ)
+static const unsigned int slabSizes[kSlabClasses] = {
+	16, 32, 48, 64, 96, 128, 192, 264, 336, 504, 672, 808, 1016, 1352, 2032
+};
+static Arena kernelArena; // Arena を持たないタスク用
+static unsigned int memorySize; // 使える RAM の合計
+static unsigned int memoryEnd;  // 使える RAM の終わり
+static Shrinker *shrinkers;     // priority の小さい順
+static MemoryWatcher *watchers;
+static bool shrinking = false;  // 解放関数の中から確保して再び呼ばないように
+static Shrinker slabShrinker = { &shrinkSlabs, 0, nullptr };
+static Shrinker poolShrinker = { &shrinkPools, 0, nullptr };
+static PoolAllocator *pools;    // 一度でも使ったオブジェクトプール
+static int poolCount;           // 番号を振ったプールの数
+static unsigned char slabIndex[kSlabMaxSize / 8 + 1]; // (size + 7) / 8 -> サイズクラス
+static void *faultPages[kFaultReservePages]; // ページフォルトの処理用に 0 埋めしたページ
+static int faultPageCount;
 
 void MemoryInit() {
 	MemoryManager *memoryManager = (MemoryManager *)ADDRESS_MEMORY_MANAGER;
-	memoryManager->frees = 0;
-	memoryManager->maxfrees = 0;
-	memoryManager->lostsize = 0;
-	memoryManager->losts = 0;
-	free0((void *)0x00001000, 0x0009e000);
-	free0((void *)0x00400000, MemoryTest(0x00400000, 0xbfffffff) - 0x00400000);
+	memoryManager->flMap = 0;
+	for (int i = 0; i < kHeapFL; ++i) {
+		memoryManager->slMap[i] = 0;
+		for (int j = 0; j < kHeapSL; ++j) {
+			memoryManager->bins[i][j] = nullptr;
+		}
+	}
+	memoryManager->stats = MemoryStats();
+	heapAddRegion(0x00001000, 0x0009f000);
+	
+	// BIOS のメモリマップ (無ければ 4MB から先を調べる)
+	BootInfo *binfo = (BootInfo *)ADDRESS_BOOTINFO;
+	E820Entry *map = (E820Entry *)ADDRESS_E820;
+	int count = binfo->e820Count;
+	E820Entry probed;
+	if (count <= 0 || count > kE820Max) {
+		probed.baseLow = 0x00400000;
+		probed.baseHigh = probed.lengthHigh = 0;
+		probed.lengthLow = MemoryTest(0x00400000, kVirtualBase - 1) - 0x00400000;
+		probed.type = kE820Usable;
+		map = &probed;
+		count = 1;
+	}
+	
+	unsigned int start, end;
+	memorySize = memoryEnd = 0;
+	for (int i = 0; i < count; ++i) {
+		if (!usableRange(map[i], start, end)) continue;
+		memorySize += end - start;
+		if (memoryEnd < end) memoryEnd = end;
+	}
+	
+	// ページ情報の表は 4MB より上で一番低い，表が収まる領域の先頭に置く
+	unsigned int table = 0xffffffff;
+	for (int i = 0; i < count; ++i) {
+		if (!usableRange(map[i], start, end) || end <= 0x00400000) continue;
+		if (start < 0x00400000) start = 0x00400000;
+		if (end - start >= memoryEnd / kPageSize * sizeof(unsigned int) && start < table) table = start;
+	}
+	if (table != 0xffffffff) {
+		buddyInit(table, memoryEnd);
+		for (int i = 0; i < count; ++i) {
+			if (usableRange(map[i], start, end)) buddyAddRegion(start, end);
+		}
+	}
+	
+	// スラブの初期化
+	for (int i = 0, j = 0; i <= kSlabMaxSize / 8; ++i) {
+		if (i * 8 > (int)slabSizes[j]) ++j;
+		slabIndex[i] = j;
+	}
+	arenaInit(&kernelArena);
+	RegisterShrinker(&slabShrinker);
+	RegisterShrinker(&poolShrinker);
 }
 
 unsigned int MemoryTotal() {
 	MemoryManager *memoryManager = (MemoryManager *)ADDRESS_MEMORY_MANAGER;
-	unsigned int t = 0;
-	for (int i = 0; i < memoryManager->frees; ++i) {
-		t += memoryManager->freeinfo[i].size;
-	}
-	return t;
+	return memoryManager->stats.freeBytes + memoryManager->buddy.freePages * kPageSize;
+}
+
+unsigned int MemorySize() {
+	return memorySize;
+}
+
+unsigned int MemoryEnd() {
+	return memoryEnd;
+}
+
+// メモリマップのエントリのうち，使える RAM で 4GB 未満かつ仮想領域より下の部分
+static bool usableRange(const E820Entry &entry, unsigned int &start, unsigned int &end) {
+	if (entry.type != kE820Usable || entry.baseHigh || entry.baseLow >= kVirtualBase) return false;
+	start = entry.baseLow;
+	end = entry.baseLow + entry.lengthLow;
+	if (entry.lengthHigh || end < start || end > kVirtualBase) end = kVirtualBase;
+	start = (start + kPageSize - 1) & ~(kPageSize - 1);
+	end &= ~(kPageSize - 1);
+	return start < end;
 }
 
 unsigned int MemoryTest(unsigned int start, unsigned int end) {
@@ -53,89 +144,822 @@ unsigned int MemoryTest(unsigned int start, unsigned int end) {
 	return i;
 }
 
-void *malloc(unsigned int size) {
-	MemoryManager *memoryManager = (MemoryManager *)ADDRESS_MEMORY_MANAGER;
+/*
+ * バディアロケータ
+ *
+ * 2^order ページのブロックをページ番号の 2^order 境界に置くので，
+ * 相方 (バディ) のページ番号は page ^ (1 << order) で求まる．
+ * 要求ページ数を 2 のべき乗に切り上げて取り，使わない後ろの端数はすぐ返す．
+ */
 
-	size += sizeof(unsigned int); // サイズ記録分空ける
-
-	for (int i = 0; i < memoryManager->frees; ++i) {
-		if (memoryManager->freeinfo[i].size >= size) {
-			unsigned int *result = (unsigned int *)memoryManager->freeinfo[i].addr;
-			memoryManager->freeinfo[i].addr += size;
-			memoryManager->freeinfo[i].size -= size;
-			if (!memoryManager->freeinfo[i].size) {
-				--memoryManager->frees;
-				for (; i < memoryManager->frees; ++i) {
-					memoryManager->freeinfo[i] = memoryManager->freeinfo[i + 1];
-				}
-			}
-			// サイズ記録(サイズ記録域含む)
-			result[0] = size;
+static void buddyInsert(unsigned int page, int order) {
+	BuddyAllocator &buddy = ((MemoryManager *)ADDRESS_MEMORY_MANAGER)->buddy;
+	BuddyBlock *block = (BuddyBlock *)(page * kPageSize);
+	block->prev = nullptr;
+	block->next = buddy.freeList[order];
+	if (block->next) block->next->prev = block;
+	buddy.freeList[order] = block;
+	buddy.pageInfo[page] = kBuddyFree | order;
+	++buddy.freeCount[order];
+	buddy.freePages += 1 << order;
+}
+
+static void buddyRemove(unsigned int page, int order) {
+	BuddyAllocator &buddy = ((MemoryManager *)ADDRESS_MEMORY_MANAGER)->buddy;
+	BuddyBlock *block = (BuddyBlock *)(page * kPageSize);
+	if (block->prev) {
+		block->prev->next = block->next;
+	} else {
+		buddy.freeList[order] = block->next;
+	}
+	if (block->next) block->next->prev = block->prev;
+	buddy.pageInfo[page] = 0;
+	--buddy.freeCount[order];
+	buddy.freePages -= 1 << order;
+}
+
+// 空きブロックを戻す (バディも空いていれば結合していく)
+static void buddyFreeBlock(unsigned int page, int order) {
+	BuddyAllocator &buddy = ((MemoryManager *)ADDRESS_MEMORY_MANAGER)->buddy;
+	for (; order < kBuddyOrders - 1; ++order) {
+		unsigned int pair = page ^ (1 << order);
+		if (pair < buddy.start || pair >= buddy.end || buddy.pageInfo[pair] != (kBuddyFree | order)) break;
+		buddyRemove(pair, order);
+		page &= ~(1 << order);
+	}
+	buddyInsert(page, order);
+}
+
+// [page, page + pages) を境界に揃ったブロックに分けて戻す
+static void buddyFreeRun(unsigned int page, unsigned int pages) {
+	while (pages) {
+		int order = page ? __builtin_ctz(page) : kBuddyOrders - 1;
+		if (order > kBuddyOrders - 1) order = kBuddyOrders - 1;
+		while ((1u << order) > pages) --order;
+		buddyFreeBlock(page, order);
+		page += 1 << order;
+		pages -= 1 << order;
+	}
+}
+
+// ページ番号 [0, end / 4KB) を管理する準備 (table にページ情報の表を置く)
+static void buddyInit(unsigned int table, unsigned int end) {
+	BuddyAllocator &buddy = ((MemoryManager *)ADDRESS_MEMORY_MANAGER)->buddy;
+	for (int i = 0; i < kBuddyOrders; ++i) {
+		buddy.freeList[i] = nullptr;
+		buddy.freeCount[i] = 0;
+	}
+	buddy.freePages = 0;
+	buddy.busy = 0;
+	buddy.end = end / kPageSize;
+	buddy.pageInfo = (unsigned int *)table;
+	for (unsigned int i = 0; i < buddy.end; ++i) {
+		buddy.pageInfo[i] = 0;
+	}
+	buddy.start = (table + buddy.end * sizeof(unsigned int) + kPageSize - 1) / kPageSize;
+}
+
+// [start, end) のうち表より後ろの部分をバディに渡す (穴の部分は渡さないので結合もされない)
+static void buddyAddRegion(unsigned int start, unsigned int end) {
+	BuddyAllocator &buddy = ((MemoryManager *)ADDRESS_MEMORY_MANAGER)->buddy;
+	unsigned int first = (start + kPageSize - 1) / kPageSize;
+	unsigned int last = end / kPageSize;
+	if (first < buddy.start) first = buddy.start;
+	if (last > buddy.end) last = buddy.end;
+	if (first < last) buddyFreeRun(first, last - first);
+}
+
+static void *buddyAlloc(unsigned int pages) {
+	BuddyAllocator &buddy = ((MemoryManager *)ADDRESS_MEMORY_MANAGER)->buddy;
+	if (!pages) pages = 1;
+	int order = pages > 1 ? 32 - __builtin_clz(pages - 1) : 0;
+	int i = order;
+	while (i < kBuddyOrders && !buddy.freeList[i]) ++i;
+	if (i >= kBuddyOrders) return nullptr;
+	
+	++buddy.busy;
+	unsigned int page = (unsigned int)buddy.freeList[i] / kPageSize;
+	buddyRemove(page, i);
+	// 必要な大きさまで半分に割っていき，後ろ半分は空きに戻す
+	while (i > order) {
+		--i;
+		buddyInsert(page + (1 << i), i);
+	}
+	// 2 のべき乗に切り上げた余りを返す
+	if ((1u << order) > pages) buddyFreeRun(page + pages, (1 << order) - pages);
+	buddy.pageInfo[page] = pages;
+	--buddy.busy;
+	return (void *)(page * kPageSize);
+}
+
+static void buddyFree(void *addr) {
+	BuddyAllocator &buddy = ((MemoryManager *)ADDRESS_MEMORY_MANAGER)->buddy;
+	unsigned int page = (unsigned int)addr / kPageSize;
+	unsigned int pages = buddy.pageInfo[page];
+	if (page < buddy.start || page >= buddy.end || !pages || (pages & kBuddyFree)) return;
+	++buddy.busy;
+	buddy.pageInfo[page] = 0;
+	buddyFreeRun(page, pages);
+	--buddy.busy;
+}
+
+// バディから確保したブロックの先頭か
+static bool isBuddyPage(unsigned int page) {
+	BuddyAllocator &buddy = ((MemoryManager *)ADDRESS_MEMORY_MANAGER)->buddy;
+	return buddy.start <= page && page < buddy.end && buddy.pageInfo[page] && !(buddy.pageInfo[page] & kBuddyFree);
+}
+
+unsigned int BuddyFreeCount(int order) {
+	BuddyAllocator &buddy = ((MemoryManager *)ADDRESS_MEMORY_MANAGER)->buddy;
+	return buddy.freeCount[order];
+}
+
+// size バイトを今すぐ確保できるか
+bool BuddyCanAlloc(unsigned int size) {
+	BuddyAllocator &buddy = ((MemoryManager *)ADDRESS_MEMORY_MANAGER)->buddy;
+	unsigned int pages = (size + kPageSize - 1) / kPageSize;
+	int order = pages > 1 ? 32 - __builtin_clz(pages - 1) : 0;
+	for (int i = order; i < kBuddyOrders; ++i) {
+		if (buddy.freeCount[i]) return true;
+	}
+	return false;
+}
+
+/*
+ * ページフォルトの処理用のページ
+ *
+ * ページフォルトは割り込み禁止の区間の中でも起こる (確保の途中で，まだ触っていないスタックのページに触るなど) ので，
+ * 処理タスクがそのままバディを使うと，書き換えている途中の表をさらに書き換えてしまう．
+ * そこで 0 埋めしたページを取っておいて，そこから渡す．補充はバディを書き換えている途中でないときだけする．
+ * どちらもページフォルト処理タスク (割り込み禁止) か，ページングを始める前からしか呼ばない．
+ */
 
-			return result + 1;
+void ReserveFaultPages() {
+	BuddyAllocator &buddy = ((MemoryManager *)ADDRESS_MEMORY_MANAGER)->buddy;
+	if (buddy.busy) return;
+	while (faultPageCount < kFaultReservePages) {
+		unsigned int *page = (unsigned int *)buddyAlloc(1);
+		if (!page) break;
+		for (int i = 0; i < kPageSize / 4; ++i) {
+			page[i] = 0;
 		}
+		faultPages[faultPageCount++] = page;
 	}
-	return 0;
 }
 
-bool free0(void *addr, unsigned int size) {
-	MemoryManager *memoryManager = (MemoryManager *)ADDRESS_MEMORY_MANAGER;
-	int i;
+// 0 埋めしたページを1枚 (無ければ nullptr)
+void *TakeFaultPage() {
+	ReserveFaultPages();
+	return faultPageCount ? faultPages[--faultPageCount] : nullptr;
+}
 
-	for (i = 0; i < memoryManager->frees; ++i)
-		if (memoryManager->freeinfo[i].addr > (unsigned int)addr)
+/*
+ * メモリ不足への対応
+ */
+
+void RegisterShrinker(Shrinker *shrinker) {
+	int e = LoadEflags();
+	Cli();
+	Shrinker **p = &shrinkers;
+	while (*p && (*p)->priority <= shrinker->priority) p = &(*p)->next;
+	shrinker->next = *p;
+	*p = shrinker;
+	StoreEflags(e);
+}
+
+void UnregisterShrinker(Shrinker *shrinker) {
+	int e = LoadEflags();
+	Cli();
+	for (Shrinker **p = &shrinkers; *p; p = &(*p)->next) {
+		if (*p == shrinker) {
+			*p = shrinker->next;
 			break;
+		}
+	}
+	StoreEflags(e);
+}
 
-	if (i > 0) {
-		if (memoryManager->freeinfo[i - 1].addr + memoryManager->freeinfo[i - 1].size == (unsigned int)addr) {
-			memoryManager->freeinfo[i - 1].size += size;
-			if (i < memoryManager->frees) {
-				if ((unsigned int)addr + size == memoryManager->freeinfo[i].addr) {
-					memoryManager->freeinfo[i - 1].size += memoryManager->freeinfo[i].size;
-					--memoryManager->frees;
-					for (; i < memoryManager->frees; ++i) {
-						memoryManager->freeinfo[i] = memoryManager->freeinfo[i + 1];
-					}
-				}
-			}
-			return true;
+void RegisterMemoryWatcher(MemoryWatcher *watcher) {
+	int e = LoadEflags();
+	Cli();
+	watcher->low = false;
+	watcher->next = watchers;
+	watchers = watcher;
+	StoreEflags(e);
+}
+
+void UnregisterMemoryWatcher(MemoryWatcher *watcher) {
+	int e = LoadEflags();
+	Cli();
+	for (MemoryWatcher **p = &watchers; *p; p = &(*p)->next) {
+		if (*p == watcher) {
+			*p = watcher->next;
+			break;
 		}
 	}
-	if (i < memoryManager->frees) {
-		if ((unsigned int)addr + size == memoryManager->freeinfo[i].addr) {
-			memoryManager->freeinfo[i].addr = (unsigned int)addr;
-			memoryManager->freeinfo[i].size += size;
-			return true;
+	StoreEflags(e);
+}
+
+// キャッシュを解放してもらい，bytes 分のページを確保できるようになったか返す
+static bool shrinkMemory(unsigned int bytes) {
+	if (shrinking) return false;
+	shrinking = true;
+	bool ok = false;
+	for (Shrinker *shrinker = shrinkers; shrinker && !ok; shrinker = shrinker->next) {
+		shrinker->shrink(bytes);
+		ok = BuddyCanAlloc(bytes);
+	}
+	shrinking = false;
+	return ok;
+}
+
+static void checkWatermarks() {
+	if (!watchers) return;
+	unsigned int total = MemoryTotal();
+	for (MemoryWatcher *watcher = watchers; watcher; watcher = watcher->next) {
+		if (!watcher->low && total < watcher->watermark) {
+			watcher->low = true;
+			watcher->queue->push(watcher->data);
+		} else if (watcher->low && total >= watcher->watermark) {
+			watcher->low = false;
 		}
 	}
-	if (memoryManager->frees < MEMORY_FREES) {
-		for (int j = memoryManager->frees; j > i; --j) {
-			memoryManager->freeinfo[j] = memoryManager->freeinfo[j - 1];
+}
+
+/*
+ * ヒープ
+ *
+ * ブロックは 8 バイト単位で，ヘッダが 8n+4 番地，中身が 8n 番地から始まるように並べる．
+ * 空きブロックはサイズから求まるリスト (第1段階 = 最上位ビット, 第2段階 = その下の3ビット) に入れ，
+ * どのリストが空でないかをビットマップで持つので，探索も解放時の結合も O(1) で済む．
+ */
+
+static inline unsigned int blockSize(const HeapBlock *block) {
+	return block->header & ~7u;
+}
+
+static inline HeapBlock *nextBlock(const HeapBlock *block) {
+	return (HeapBlock *)((unsigned int)block + blockSize(block));
+}
+
+static inline void setFooter(HeapBlock *block) {
+	((unsigned int *)nextBlock(block))[-1] = blockSize(block);
+}
+
+// 空きブロックのサイズ -> リストの番号
+static inline void mappingInsert(unsigned int size, int &fl, int &sl) {
+	fl = 31 - __builtin_clz(size);
+	sl = (size >> (fl - kHeapSLShift)) & (kHeapSL - 1);
+}
+
+// 要求サイズ -> そのサイズ以上が必ず入っているリストの番号
+static inline void mappingSearch(unsigned int size, int &fl, int &sl) {
+	size += (1 << (31 - __builtin_clz(size) - kHeapSLShift)) - 1;
+	mappingInsert(size, fl, sl);
+}
+
+static void insertBlock(HeapBlock *block) {
+	MemoryManager *memoryManager = (MemoryManager *)ADDRESS_MEMORY_MANAGER;
+	int fl, sl;
+	mappingInsert(blockSize(block), fl, sl);
+	
+	block->prev = nullptr;
+	block->next = memoryManager->bins[fl][sl];
+	if (block->next) block->next->prev = block;
+	memoryManager->bins[fl][sl] = block;
+	memoryManager->flMap |= 1 << fl;
+	memoryManager->slMap[fl] |= 1 << sl;
+	
+	memoryManager->stats.freeBytes += blockSize(block);
+	++memoryManager->stats.freeBlocks;
+}
+
+static void removeBlock(HeapBlock *block) {
+	MemoryManager *memoryManager = (MemoryManager *)ADDRESS_MEMORY_MANAGER;
+	int fl, sl;
+	mappingInsert(blockSize(block), fl, sl);
+	
+	if (block->prev) {
+		block->prev->next = block->next;
+	} else {
+		memoryManager->bins[fl][sl] = block->next;
+		if (!block->next) {
+			memoryManager->slMap[fl] &= ~(1 << sl);
+			if (!memoryManager->slMap[fl]) memoryManager->flMap &= ~(1 << fl);
 		}
-		++memoryManager->frees;
-		if (memoryManager->maxfrees < memoryManager->frees) {
-			memoryManager->maxfrees = memoryManager->frees;
+	}
+	if (block->next) block->next->prev = block->prev;
+	
+	memoryManager->stats.freeBytes -= blockSize(block);
+	--memoryManager->stats.freeBlocks;
+}
+
+// size 以上の空きブロックをリストから外して返す
+static HeapBlock *findBlock(unsigned int size) {
+	MemoryManager *memoryManager = (MemoryManager *)ADDRESS_MEMORY_MANAGER;
+	int fl, sl;
+	unsigned int scan = 1;
+	mappingSearch(size, fl, sl);
+	if (fl >= kHeapFL) {
+		// どのリストにも入らない大きさ
+		++memoryManager->stats.failures;
+		return nullptr;
+	}
+	
+	unsigned int slMap = memoryManager->slMap[fl] & (~0u << sl);
+	if (!slMap) {
+		// この段階には無いので，より大きい段階を探す
+		unsigned int flMap = fl + 1 < kHeapFL ? memoryManager->flMap & (~0u << (fl + 1)) : 0;
+		++scan;
+		if (!flMap) {
+			++memoryManager->stats.failures;
+			return nullptr;
 		}
-		memoryManager->freeinfo[i].addr = (unsigned int)addr;
-		memoryManager->freeinfo[i].size = size;
-		return true;
+		fl = __builtin_ctz(flMap);
+		slMap = memoryManager->slMap[fl];
 	}
-	++memoryManager->losts;
-	memoryManager->lostsize += size;
-	return false;
+	sl = __builtin_ctz(slMap);
+	
+	++memoryManager->stats.allocs;
+	memoryManager->stats.scans += scan;
+	if (memoryManager->stats.maxScan < scan) memoryManager->stats.maxScan = scan;
+	
+	HeapBlock *block = memoryManager->bins[fl][sl];
+	removeBlock(block);
+	return block;
+}
+
+// 使用中にしたブロックの後ろの余りを切り離して空きブロックにする
+static void trimBlock(HeapBlock *block, unsigned int size) {
+	unsigned int rest = blockSize(block) - size;
+	if (rest >= (unsigned int)kHeapMinBlock) {
+		HeapBlock *remain = (HeapBlock *)((unsigned int)block + size);
+		block->header = size | (block->header & 7);
+		remain->header = rest | kBlockPrevUsed;
+		setFooter(remain);
+		insertBlock(remain);
+	} else {
+		nextBlock(block)->header |= kBlockPrevUsed;
+	}
+}
+
+// [start, end) をヒープに加える
+static void heapAddRegion(unsigned int start, unsigned int end) {
+	unsigned int first = ((start + 7) & ~7u) + 4;
+	unsigned int last = ((end - 8) & ~7u) + 4; // 番兵の位置
+	if (last <= first || last - first < (unsigned int)kHeapMinBlock) return;
+	
+	HeapBlock *block = (HeapBlock *)first;
+	block->header = (last - first) | kBlockPrevUsed;
+	setFooter(block);
+	((HeapBlock *)last)->header = 0 | kBlockUsed; // 番兵 (サイズ 0 の使用中ブロック)
+	insertBlock(block);
+}
+
+static void *heapAlloc(unsigned int size) {
+	// ヘッダ分を足して 8 バイト単位に切り上げ
+	size = (size + sizeof(unsigned int) + 7) & ~7u;
+	if (size < (unsigned int)kHeapMinBlock) size = kHeapMinBlock;
+	
+	int e = LoadEflags();
+	Cli();
+	HeapBlock *block = findBlock(size);
+	if (!block) {
+		// バディからページをもらって広げる (ヘッダと番兵の 8 バイト分多めに)
+		unsigned int pages = (size + 8 + kPageSize - 1) / kPageSize;
+		if (pages < kHeapGrowPages) pages = kHeapGrowPages;
+		unsigned int region = (unsigned int)AllocPages(pages);
+		if (region) {
+			heapAddRegion(region, region + pages * kPageSize);
+			block = findBlock(size);
+		}
+	}
+	if (block) {
+		block->header |= kBlockUsed;
+		trimBlock(block, size);
+	}
+	StoreEflags(e);
+	
+	return block ? &block->next : nullptr;
+}
+
+static void heapFree(void *addr) {
+	int e = LoadEflags();
+	Cli();
+	HeapBlock *block = (HeapBlock *)((unsigned int *)addr - 1);
+	unsigned int size = blockSize(block);
+	HeapBlock *next = nextBlock(block);
+	
+	// 後ろと結合
+	if (!(next->header & kBlockUsed)) {
+		removeBlock(next);
+		size += blockSize(next);
+	}
+	// 前と結合
+	if (!(block->header & kBlockPrevUsed)) {
+		HeapBlock *prev = (HeapBlock *)((unsigned int)block - ((unsigned int *)block)[-1]);
+		removeBlock(prev);
+		size += blockSize(prev);
+		block = prev;
+	}
+	
+	block->header = size | (block->header & kBlockPrevUsed);
+	next = nextBlock(block);
+	if (((unsigned int)block & (kPageSize - 1)) == 4 && blockSize(next) == 0 && isBuddyPage((unsigned int)block / kPageSize)) {
+		// バディからもらった領域が丸ごと空いたら返す (次が番兵．番兵にも kBlockPrevUsed が立つのでサイズで見る)
+		buddyFree((void *)((unsigned int)block - 4));
+	} else {
+		setFooter(block);
+		next->header &= ~kBlockPrevUsed;
+		insertBlock(block);
+	}
+	StoreEflags(e);
+}
+
+void *malloc(unsigned int size) {
+#ifdef HEAP_PROFILE
+	unsigned int caller = (unsigned int)__builtin_return_address(0);
+	void *p = heapAlloc(size + kProfileHeader);
+	return p ? ProfileAlloc(p, size, caller) : nullptr;
+#else
+	return heapAlloc(size);
+#endif
 }
 
 bool free(void *addr) {
-	unsigned int *realaddr = (unsigned int *)addr - 1;
-	return free0(realaddr, realaddr[0]);
+	if (!addr) return false;
+#ifdef HEAP_PROFILE
+	addr = ProfileFree(addr);
+#endif
+	heapFree(addr);
+	return true;
 }
 
 void *malloc4k(unsigned int size) {
-	return malloc((size + 0xfff) & 0xfffff000);
+	return AllocPages((size + 0xfff) / kPageSize);
 }
 
 bool free4k(void *addr) {
-	return free(addr/*, (size + 0xfff) & 0xfffff000*/);
+	if (!addr) return false;
+	FreePages(addr);
+	return true;
+}
+
+// 4KB 境界に揃ったページを確保
+void *AllocPages(unsigned int pages) {
+	int e = LoadEflags();
+	Cli();
+	void *addr = buddyAlloc(pages);
+	if (!addr && shrinkMemory(pages * kPageSize)) addr = buddyAlloc(pages);
+	checkWatermarks();
+	StoreEflags(e);
+	return addr;
+}
+
+void FreePages(void *addr) {
+	int e = LoadEflags();
+	Cli();
+	buddyFree(addr);
+	checkWatermarks();
+	StoreEflags(e);
+}
+
+const MemoryStats &HeapStats() {
+	MemoryManager *memoryManager = (MemoryManager *)ADDRESS_MEMORY_MANAGER;
+	return memoryManager->stats;
+}
+
+// 最大の空きブロック (一番上のリストだけ調べる)
+unsigned int HeapLargestFree() {
+	MemoryManager *memoryManager = (MemoryManager *)ADDRESS_MEMORY_MANAGER;
+	unsigned int largest = 0;
+	int e = LoadEflags();
+	Cli();
+	if (memoryManager->flMap) {
+		int fl = 31 - __builtin_clz(memoryManager->flMap);
+		int sl = 31 - __builtin_clz(memoryManager->slMap[fl]);
+		for (HeapBlock *block = memoryManager->bins[fl][sl]; block; block = block->next) {
+			if (largest < blockSize(block)) largest = blockSize(block);
+		}
+	}
+	StoreEflags(e);
+	return largest;
+}
+
+// Arena のページを確保してリストにつなぐ
+static SlabPage *arenaAllocPages(Arena *arena, unsigned int pages) {
+	SlabPage *page = (SlabPage *)AllocPages(pages);
+	if (!page) return nullptr;
+	
+	page->arena = arena;
+	page->pages = pages;
+	page->pool = nullptr;
+	page->arenaPrev = nullptr;
+	page->arenaNext = arena->pages;
+	if (page->arenaNext) page->arenaNext->arenaPrev = page;
+	arena->pages = page;
+	arena->resident += pages * kPageSize;
+	return page;
+}
+
+static void arenaFreePages(SlabPage *page) {
+	Arena *arena = page->arena;
+	if (page->arenaPrev) {
+		page->arenaPrev->arenaNext = page->arenaNext;
+	} else {
+		arena->pages = page->arenaNext;
+	}
+	if (page->arenaNext) page->arenaNext->arenaPrev = page->arenaPrev;
+	arena->resident -= page->pages * kPageSize;
+	FreePages(page);
+}
+
+// スラブ用のページを1枚用意してオブジェクトを free list につなぐ
+static SlabPage *newSlab(Arena *arena, int sizeClass) {
+	SlabPage *page = arenaAllocPages(arena, 1);
+	if (!page) return nullptr;
+	
+	SlabCache &cache = arena->caches[sizeClass];
+	char *obj = (char *)(page + 1);
+	char *end = (char *)page + kPageSize;
+	page->sizeClass = sizeClass;
+	page->inuse = 0;
+	page->freeList = nullptr;
+	for (; obj + cache.size <= end; obj += cache.size) {
+		*(void **)obj = page->freeList;
+		page->freeList = obj;
+	}
+	page->prev = nullptr;
+	page->next = cache.partial;
+	if (page->next) page->next->prev = page;
+	cache.partial = page;
+	++cache.pages;
+	return page;
+}
+
+static void unlinkSlab(SlabPage *page) {
+	SlabCache &cache = page->arena->caches[page->sizeClass];
+	if (page->prev) {
+		page->prev->next = page->next;
+	} else {
+		cache.partial = page->next;
+	}
+	if (page->next) page->next->prev = page->prev;
+	page->next = page->prev = nullptr;
+}
+
+static void *slabAlloc(Arena *arena, unsigned int size) {
+	int sizeClass = slabIndex[(size + 7) / 8];
+	SlabCache &cache = arena->caches[sizeClass];
+	SlabPage *page = cache.partial;
+	if (!page) {
+		page = newSlab(arena, sizeClass);
+		if (!page) return nullptr;
+	}
+	
+	void *obj = page->freeList;
+	page->freeList = *(void **)obj;
+	++page->inuse;
+	if (!page->freeList) {
+		// 満杯になったのでリストから外す
+		unlinkSlab(page);
+	}
+	return obj;
+}
+
+static void slabFree(SlabPage *page, void *obj) {
+	SlabCache &cache = page->arena->caches[page->sizeClass];
+	bool wasFull = !page->freeList;
+	*(void **)obj = page->freeList;
+	page->freeList = obj;
+	--page->inuse;
+	
+	if (wasFull) {
+		page->prev = nullptr;
+		page->next = cache.partial;
+		if (page->next) page->next->prev = page;
+		cache.partial = page;
+	}
+	if (!page->inuse && (page->prev || page->next)) {
+		// 空になったページは返す (最後の1枚は次回のために取っておく)
+		unlinkSlab(page);
+		--cache.pages;
+		arenaFreePages(page);
+	}
+}
+
+// スラブとして使っているメモリの合計
+unsigned int SlabTotal() {
+	unsigned int t = 0;
+	for (int i = 0; i < kSlabClasses; ++i) {
+		t += kernelArena.caches[i].pages * kPageSize;
+	}
+	return t;
+}
+
+// カーネルの Arena で次回のために取っておいた空のスラブを返す
+static unsigned int shrinkSlabs(unsigned int bytes) {
+	unsigned int freed = 0;
+	for (int i = 0; i < kSlabClasses; ++i) {
+		SlabCache &cache = kernelArena.caches[i];
+		SlabPage *page = cache.partial;
+		while (page) {
+			SlabPage *next = page->next;
+			if (!page->inuse) {
+				unlinkSlab(page);
+				--cache.pages;
+				arenaFreePages(page);
+				freed += kPageSize;
+			}
+			page = next;
+		}
+	}
+	return freed;
+}
+
+static void arenaInit(Arena *arena) {
+	for (int i = 0; i < kSlabClasses; ++i) {
+		arena->caches[i].size = slabSizes[i];
+		arena->caches[i].partial = nullptr;
+		arena->caches[i].pages = 0;
+	}
+	for (int i = 0; i < kArenaPools; ++i) {
+		arena->pools[i] = nullptr;
+	}
+	arena->pages = nullptr;
+	arena->resident = 0;
+}
+
+Arena *ArenaCreate() {
+	int e = LoadEflags();
+	Cli();
+	Arena *arena = (Arena *)slabAlloc(&kernelArena, sizeof(Arena));
+	if (arena) arenaInit(arena);
+	StoreEflags(e);
+	return arena;
+}
+
+// Arena のページをすべて返す (中のオブジェクトのデストラクタは呼ばない)
+void ArenaRelease(Arena *arena) {
+	if (!arena) return;
+	
+	int e = LoadEflags();
+	Cli();
+	while (arena->pages) {
+		SlabPage *page = arena->pages;
+		if (page->pool) {
+			// 中のオブジェクトはページと一緒に消える
+			page->pool->inuse -= page->inuse;
+			--page->pool->pages;
+		}
+		arenaFreePages(page);
+	}
+	slabFree((SlabPage *)((unsigned int)arena & 0xfffff000), arena);
+	StoreEflags(e);
+}
+
+/*
+ * オブジェクトプール
+ *
+ * ページは今のタスクの Arena からもらい，空きのあるページのリストも Arena ごとに持つ．
+ * タブのタスクで作ったオブジェクトは，中身が確保したメモリと一緒にタブを閉じたときに返る．
+ */
+
+// プールのページを1枚用意してオブジェクトを free list につなぐ
+SlabPage *PoolAllocator::newPage(Arena *arena) {
+	SlabPage *page = arenaAllocPages(arena, 1);
+	if (!page) return nullptr;
+	
+	char *obj = (char *)(page + 1);
+	char *end = (char *)page + kPageSize;
+	page->sizeClass = kPoolPage;
+	page->pool = this;
+	page->inuse = 0;
+	page->freeList = nullptr;
+	for (; obj + size <= end; obj += size) {
+		*(void **)obj = page->freeList;
+		page->freeList = obj;
+	}
+	page->prev = nullptr;
+	page->next = nullptr;
+	arena->pools[id] = page;
+	++pages;
+	return page;
+}
+
+// 空になったページを Arena に返す
+void PoolAllocator::freePage(SlabPage *page) {
+	SlabPage *&partial = page->arena->pools[id];
+	if (page->prev) {
+		page->prev->next = page->next;
+	} else {
+		partial = page->next;
+	}
+	if (page->next) page->next->prev = page->prev;
+	--pages;
+	arenaFreePages(page);
+}
+
+void *PoolAllocator::alloc() {
+	int e = LoadEflags();
+	Cli();
+	if (id < 0) {
+		// 初めて使うプール
+		if (poolCount >= kArenaPools) {
+			StoreEflags(e);
+			halt("Too many object pools!");
+		}
+		id = poolCount++;
+		next = pools;
+		pools = this;
+	}
+	Arena *arena = currentArena();
+	SlabPage *page = arena->pools[id];
+	if (!page) {
+		page = newPage(arena);
+		if (!page) {
+			StoreEflags(e);
+			OutOfMemory();
+		}
+	}
+	
+	void *obj = page->freeList;
+	page->freeList = *(void **)obj;
+	++page->inuse;
+	if (!page->freeList) {
+		// 満杯になったのでリストから外す
+		arena->pools[id] = page->next;
+		if (page->next) page->next->prev = nullptr;
+		page->next = nullptr;
+	}
+	++allocs;
+	if (++inuse > peak) peak = inuse;
+	StoreEflags(e);
+	return obj;
+}
+
+void PoolAllocator::free(void *obj) {
+	if (!obj) return;
+	
+	int e = LoadEflags();
+	Cli();
+	SlabPage *page = (SlabPage *)((unsigned int)obj & 0xfffff000);
+	SlabPage *&partial = page->arena->pools[id];
+	bool wasFull = !page->freeList;
+	*(void **)obj = page->freeList;
+	page->freeList = obj;
+	--page->inuse;
+	--inuse;
+	++frees;
+	
+	if (wasFull) {
+		page->prev = nullptr;
+		page->next = partial;
+		if (page->next) page->next->prev = page;
+		partial = page;
+	}
+	if (!page->inuse && (page->prev || page->next)) {
+		// 空になったページは返す (最後の1枚は次回のために取っておく)
+		freePage(page);
+	}
+	StoreEflags(e);
+}
+
+// カーネルの Arena で取っておいた空のページを返す
+unsigned int PoolAllocator::shrink() {
+	unsigned int freed = 0;
+	if (id < 0) return 0;
+	int e = LoadEflags();
+	Cli();
+	SlabPage *page = kernelArena.pools[id];
+	while (page) {
+		SlabPage *nextPage = page->next;
+		if (!page->inuse) {
+			freePage(page);
+			freed += kPageSize;
+		}
+		page = nextPage;
+	}
+	StoreEflags(e);
+	return freed;
+}
+
+PoolAllocator *PoolList() {
+	return pools;
+}
+
+static unsigned int shrinkPools(unsigned int bytes) {
+	unsigned int freed = 0;
+	for (PoolAllocator *pool = pools; pool; pool = pool->next) {
+		freed += pool->shrink();
+	}
+	return freed;
+}
+
+// 今のタスクの Arena
+static Arena *currentArena() {
+	Task *task = TaskSwitcher::getNowTask();
+	return task && task->arena ? task->arena : &kernelArena;
 }
 
 /*extern "C" void *MemCopy(void* s1, void* s2, unsigned int size) {
@@ -158,22 +982,77 @@ bool free4k(void *addr) {
 	return s1;
 }*/
 
+// 続けられないので止める
+static void halt(const char *reason) {
+	SheetCtl::blueScreen(reason);
+	for (;;) {
+		Cli();
+		Hlt();
+	}
+}
+
+// null を返しても呼び出し側はそのまま使うので，ここで止める
+void OutOfMemory() {
+	halt("Out of Memory!");
+}
+
+// 小さいものはスラブから，大きいものはページ単位で確保する
+static void *kernelNew(unsigned int size, unsigned int caller) {
+	void *p;
+#ifdef HEAP_PROFILE
+	size += kProfileHeader;
+#endif
+	int e = LoadEflags();
+	Cli();
+	Arena *arena = currentArena();
+	if (size <= (unsigned int)kSlabMaxSize) {
+		p = slabAlloc(arena, size ? size : 1);
+	} else {
+		SlabPage *page = arenaAllocPages(arena, (size + sizeof(SlabPage) + kPageSize - 1) / kPageSize);
+		if (page) {
+			page->sizeClass = kLargeBlock;
+			p = page + 1;
+		} else {
+			p = nullptr;
+		}
+	}
+	StoreEflags(e);
+	if (!p) OutOfMemory();
+#ifdef HEAP_PROFILE
+	p = ProfileAlloc(p, size - kProfileHeader, caller);
+#endif
+	return p;
+}
+
+static void kernelDelete(void *address) {
+	if (!address) return;
+#ifdef HEAP_PROFILE
+	address = ProfileFree(address);
+#endif
+	
+	int e = LoadEflags();
+	Cli();
+	SlabPage *page = (SlabPage *)((unsigned int)address & 0xfffff000);
+	if (page->sizeClass == kLargeBlock) {
+		arenaFreePages(page);
+	} else {
+		slabFree(page, address);
+	}
+	StoreEflags(e);
+}
+
 void *operator new(long unsigned int size) {
-	return malloc4k(size);
+	return kernelNew(size, (unsigned int)__builtin_return_address(0));
 }
 
 void *operator new[](long unsigned int size) {
-	return malloc4k(size);
+	return kernelNew(size, (unsigned int)__builtin_return_address(0));
 }
 
 void operator delete(void *address) noexcept {
-	if (address) {
-		free4k(address);
-	}
+	kernelDelete(address);
 }
 
 void operator delete[](void *address) noexcept {
-	if (address) {
-		free4k(address);
-	}
+	kernelDelete(address);
 }
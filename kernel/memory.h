@@ -9,21 +9,137 @@
 const int EFLAGS_AC_BIT     = 0x00040000;
 const int CR0_CACHE_DISABLE = 0x60000000;
 
-const int MEMORY_FREES = 4090;
 const int ADDRESS_MEMORY_MANAGER = 0x003c0000;
 
-struct FreeInfo {
-	unsigned int addr, size;
+// ヒープ (境界タグ + 2段階の分離空きリスト)
+const int kHeapFL = 32;          // 第1段階: サイズの最上位ビット
+const int kHeapSLShift = 3;
+const int kHeapSL = 1 << kHeapSLShift; // 第2段階: その下の3ビットで8分割
+const int kHeapMinBlock = 16;
+const unsigned int kBlockUsed = 1;     // このブロックは使用中
+const unsigned int kBlockPrevUsed = 2; // 直前のブロックが使用中
+
+// ブロックの先頭には必ず header がある．
+// 空きブロックだけ next/prev と末尾のサイズ (フッタ) を持つ
+struct HeapBlock {
+	unsigned int header; // サイズ | kBlockUsed | kBlockPrevUsed
+	HeapBlock *next, *prev;
+};
+
+struct MemoryStats {
+	unsigned int freeBytes;  // 空き容量
+	unsigned int freeBlocks; // 空きブロック数
+	unsigned int allocs;     // malloc 回数
+	unsigned int scans;      // malloc で調べたリストの数の合計
+	unsigned int maxScan;    // 1回の malloc で調べたリストの数の最大
+	unsigned int failures;   // 確保に失敗した回数
+};
+
+// ページ単位のバディアロケータ (2^order ページのブロックを分割・結合する)
+const int kBuddyOrders = 20;                // order 0 (4KB) ～ 19 (2GB)
+const unsigned int kBuddyFree = 0x80000000; // pageInfo: 空きブロックの先頭 (下位は order)
+const unsigned int kHeapGrowPages = 64;     // ヒープが足りなくなったらバディからもらう最小ページ数
+
+const int kFaultReservePages = 8;           // ページフォルトの処理用に 0 埋めして取っておくページ数
+
+struct BuddyBlock {
+	BuddyBlock *next, *prev;
+};
+
+struct BuddyAllocator {
+	unsigned int start, end; // 管理するページ番号 [start, end)
+	unsigned int *pageInfo;  // ページ番号ごと: 空きブロックの先頭なら kBuddyFree | order，確保した先頭ならページ数，他は 0
+	BuddyBlock *freeList[kBuddyOrders];
+	unsigned int freeCount[kBuddyOrders]; // order ごとの空きブロック数
+	unsigned int freePages;
+	int busy; // 表を書き換えている途中か (その間のページフォルトではバディを使えない)
 };
 
 struct MemoryManager {
-	int frees, maxfrees, lostsize, losts;
-	FreeInfo freeinfo[MEMORY_FREES];
+	unsigned int flMap;             // 空きブロックがある第1段階のビットマップ
+	unsigned char slMap[kHeapFL];   // 第2段階のビットマップ
+	HeapBlock *bins[kHeapFL][kHeapSL];
+	MemoryStats stats;
+	BuddyAllocator buddy;
+};
+
+// 小さいオブジェクト用のスラブ (4KB ページをサイズクラスごとに切り分ける)
+const int kPageSize = 4096;
+const int kSlabClasses = 15;
+const int kSlabMaxSize = 2032;
+const unsigned short kLargeBlock = 0xffff; // スラブではなくページ単位で確保したブロック
+
+const unsigned short kPoolPage = 0xfffe;   // オブジェクトプールのページ
+const int kArenaPools = 32;                // 使えるオブジェクトプールの種類の数
+
+struct Arena;
+class PoolAllocator;
+
+// 各ページ先頭のヘッダ (operator new が返すアドレスの下位 12bit を落とすとここに着く)
+struct SlabPage {
+	unsigned short sizeClass; // kLargeBlock なら大きなブロック，kPoolPage ならプールのページ
+	unsigned short inuse;
+	void *freeList;           // 空きオブジェクトのリスト
+	SlabPage *next, *prev;    // 空きのあるスラブ (プールのページ) のリスト
+	Arena *arena;             // このページを持っている Arena
+	SlabPage *arenaNext, *arenaPrev; // Arena の全ページのリスト
+	unsigned int pages;       // ページ数
+	PoolAllocator *pool;      // プールのページならそのプール
+};
+
+struct SlabCache {
+	unsigned int size; // オブジェクトサイズ
+	SlabPage *partial; // 空きオブジェクトを持つページ
+	int pages;         // 確保しているページ数
+};
+
+// operator new が使うページの持ち主．タブのタスクは自分の Arena を持ち，閉じるときにまとめて返す
+struct Arena {
+	SlabCache caches[kSlabClasses];
+	SlabPage *pools[kArenaPools]; // プールごとの空きオブジェクトを持つページ (PoolAllocator の番号で引く)
+	SlabPage *pages;       // この Arena の全ページ
+	unsigned int resident; // 確保しているバイト数
+};
+
+class TaskQueue;
+
+// メモリが足りないときに確保に失敗する前に呼ばれる，キャッシュの解放関数
+struct Shrinker {
+	unsigned int (*shrink)(unsigned int bytes); // bytes を目安に解放し，解放したバイト数を返す
+	int priority;                               // 小さいほど先に呼ばれる
+	Shrinker *next;
+};
+
+// 空きが watermark を下回ったら queue に data を送る (上回ったらまた送るようになる)
+struct MemoryWatcher {
+	unsigned int watermark;
+	TaskQueue *queue;
+	int data;
+	bool low;
+	MemoryWatcher *next;
 };
 
 void         MemoryInit();
 unsigned int MemoryTotal();
+unsigned int MemorySize();
+unsigned int MemoryEnd();
 unsigned int MemoryTest(unsigned int, unsigned int);
+void         *AllocPages(unsigned int pages);
+void         FreePages(void *addr);
+unsigned int SlabTotal();
+void         RegisterShrinker(Shrinker *shrinker);
+void         UnregisterShrinker(Shrinker *shrinker);
+void         RegisterMemoryWatcher(MemoryWatcher *watcher);
+void         UnregisterMemoryWatcher(MemoryWatcher *watcher);
+Arena        *ArenaCreate();
+void         ArenaRelease(Arena *arena);
+const MemoryStats &HeapStats();
+unsigned int HeapLargestFree();
+unsigned int BuddyFreeCount(int order);
+bool         BuddyCanAlloc(unsigned int size);
+void         ReserveFaultPages();
+void         *TakeFaultPage();
+[[noreturn]] void OutOfMemory();
 
 extern "C" {
 	void *malloc(unsigned int);
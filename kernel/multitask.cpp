@@ -1,16 +1,27 @@
 #include "../headers.h"
 
-TaskQueue::TaskQueue(int size, Task *task_) : Queue<int>(size), task(task_) {}
+ObjectPool<TaskQueue> TaskQueue::pool("TaskQueue");
 
+TaskQueue::TaskQueue(int size, Task *task_) : SpscRing<int>(size), task(task_) {}
+
+// 書き込むのは割り込みハンドラや他のタスクなので，割り込みを止めて1つずつにする
 bool TaskQueue::push(int data) {
-	if (Queue::push(data)) {
-		// タスクが指定されていてかつスリープしていたら起こす
-		if (task && !task->running) {
-			task->run(-1, 0);
-		}
-		return true;
+	int e = LoadEflags();
+	Cli();
+	bool pushed = SpscRing::push(data);
+	// タスクが指定されていてかつスリープしていたら起こす
+	if (pushed && task && !task->running) {
+		task->run(-1, 0);
 	}
-	return false;
+	StoreEflags(e);
+	return pushed;
+}
+
+// 空なら 0
+int TaskQueue::pop() {
+	int data = 0;
+	SpscRing::pop(data);
+	return data;
 }
 
 // メインタスク用の Constructor
@@ -22,6 +33,7 @@ Task::Task() {
 	SetSegmentDescriptor((SegmentDescriptor *)kAdrGdt + kTaskGDT0, 103, (int)&tss, kArTss32);
 	
 	// Task State Segment の設定
+	tss.cr3 = PageDirectory();
 	tss.eflags = 0x00000202;
 	tss.eax = 0;
 	tss.ecx = 0;
@@ -39,14 +51,14 @@ Task::Task() {
 	tss.ss0 = 0;
 	
 	// add this pointer to the list of tasks
-	TaskSwitcher::_taskList->push_back(this);
+	TaskSwitcher::_taskList.push_back(*this);
 }
 
 Task::~Task() {
-	TaskSwitcher::_taskList->remove(this);
+	TaskSwitcher::_taskList.remove(*this);
 	sleep();
 	delete queue;
-	free4k(reinterpret_cast<void *>(stack));
+	ReleaseMemory(reinterpret_cast<void *>(stack));
 }
 
 void Task::run(int newLevel, int newPriority) {
@@ -80,8 +92,8 @@ void Task::sleep() {
 
 int       TaskSwitcher::nowLevel     = 0;
 bool      TaskSwitcher::levelChanged = false;
-List<Task *> *TaskSwitcher::_taskList;
-List<Task *> *const &TaskSwitcher::taskList = _taskList;
+IntrusiveList<Task, &Task::taskHook> TaskSwitcher::_taskList;
+const IntrusiveList<Task, &Task::taskHook> &TaskSwitcher::taskList = _taskList;
 TaskLevel TaskSwitcher::_level[MAX_TASKLEVELS];
 const TaskLevel (&TaskSwitcher::level)[MAX_TASKLEVELS] = _level;
 Task      *TaskSwitcher::taskFPU     = nullptr;
@@ -89,9 +101,6 @@ Timer     *TaskSwitcher::timer;
 int       TaskSwitcher::taskCount    = 1; // メインタスクの分をあらかじめ足しておく
 
 Task *TaskSwitcher::init() {
-	// タスクリストの初期化
-	_taskList = new List<Task *>();
-	
 	// メインタスクの設定
 	Task *task = new Task();
 	task->_name = "メインタスク";
@@ -111,14 +120,14 @@ Task *TaskSwitcher::init() {
 void TaskSwitcher::switchTask() {
 	TaskLevel *tl = &_level[nowLevel];
 	Task *newTask;
-	Task *nowTask = tl->tasks[tl->now];
-	++tl->now;
-	if (tl->now == tl->running) tl->now = 0;
+	Task *nowTask = tl->now;
+	tl->now = tl->tasks.next(*nowTask);
+	if (!tl->now) tl->now = tl->tasks.front();
 	if (levelChanged) {
 		switchTaskSub();
 		tl = &_level[nowLevel];
 	}
-	newTask = tl->tasks[tl->now];
+	newTask = tl->now;
 	timer->set(newTask->priority);
 	if (newTask != nowTask) FarJump(0, newTask->selector);
 }
@@ -126,7 +135,7 @@ void TaskSwitcher::switchTask() {
 void TaskSwitcher::switchTaskSub() {
 	for (int i = 0; i < MAX_TASKLEVELS; ++i) {
 		// Idle Task がいるので絶対に途中で止まる
-		if (level[i].running > 0) {
+		if (!level[i].tasks.empty()) {
 			nowLevel = i;
 			levelChanged = false;
 			return;
@@ -135,42 +144,24 @@ void TaskSwitcher::switchTaskSub() {
 }
 
 Task *TaskSwitcher::getNowTask() {
-	TaskLevel *tl = &_level[nowLevel];
-	return tl->tasks[tl->now];
+	return _level[nowLevel].now;
 }
 
 void TaskSwitcher::add(Task *task) {
 	TaskLevel *tl = &_level[task->level];
-	if (tl->running < kMaxTasksLevel) {
-		tl->tasks[tl->running] = task;
-		++tl->running;
-		task->_running = true;
-	}
+	tl->tasks.push_back(*task);
+	if (!tl->now) tl->now = task;
+	task->_running = true;
 }
 
 void TaskSwitcher::remove(Task *task) {
-	int i;
 	TaskLevel *tl = &_level[task->level];
 
-	// 現在のレベル内でのこのタスクのインデックス番号を取得
-	for (i = 0; i < tl->running; ++i)
-		if (tl->tasks[i] == task)
-			break;
-
-	// 現在のレベルのタスク稼働数を1減らす
-	--tl->running;
-	
-	// この瞬間に動作中のタスクのインデックス番号を修正
-	if (i < tl->now) --tl->now;
-	
-	// この瞬間に動作中のタスクのインデックス番号が範囲を超えていたら
-	if (tl->now >= tl->running) tl->now = 0;
+	// 動作中のタスクを外すなら，次に動くのはその次のタスク (最後なら先頭)
+	if (tl->now == task) tl->now = tl->tasks.next(*task);
+	tl->tasks.remove(*task);
+	if (!tl->now) tl->now = tl->tasks.front();
 	
 	// フラグの書き換え
 	task->_running = false;
-
-	// このレベル内のタスクの配列をずらす
-	for (; i < tl->running; ++i) {
-		tl->tasks[i] = tl->tasks[i + 1];
-	}
 }
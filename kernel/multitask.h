@@ -6,11 +6,11 @@
 
 #include <stddef.h>
 #include <pistring.h>
-#include <Queue.h>
-#include <List.h>
+#include <SpscRing.h>
+#include <IntrusiveList.h>
+#include <ObjectPool.h>
 
 const int kTaskGDT0 = 3;
-const int kMaxTasksLevel = 100;
 const int MAX_TASKLEVELS = 10;
 
 struct TSS32 {
@@ -21,51 +21,25 @@ struct TSS32 {
 };
 
 class Task;
+class TaskSwitcher;
 
-struct TaskLevel {
-	int running; // the number of running tasks on the level
-	int now; // the index of the now running task
-	Task *tasks[kMaxTasksLevel]; // tasks on the level
-	
-	TaskLevel() : running(0), now(0) {}
-};
-
-class Timer;
-
-class TaskSwitcher {
-private:
-	static int nowLevel;
-	static bool levelChanged; // 次回タスクスイッチ時にレベルも変えたほうがいいか
-	static List<Task *> *_taskList;
-	static TaskLevel _level[];
-	static Task *taskFPU;
-	static Timer *timer;
-	static int taskCount;
-	
-	static void switchTask();
-	static void switchTaskSub();
-	static void add(Task *task);
-	static void remove(Task *task);
-
-public:
-	static const TaskLevel (&level)[MAX_TASKLEVELS];
-	static List<Task *> *const &taskList;
-
-	friend class Task;
-	friend void IntHandler07(int *esp); // FPU
-	friend void IntHandler20(int *esp); // PIT割り込み
-	static Task *init();
-	static Task *getNowTask();
-};
-
-
-class TaskQueue : public Queue<int> {
+// タスクに届くデータのキュー．読むのは持ち主のタスクだけなので，読む側は割り込みを止めなくていい
+class TaskQueue : public SpscRing<int> {
 private:
 	Task *task;
 
 public:
 	TaskQueue(int size, Task *task_);
 	bool push(int data);
+	using SpscRing::pop;
+	int pop();
+	bool isempty() const {
+		return empty();
+	}
+	
+	static ObjectPool<TaskQueue> pool;
+	static void *operator new(long unsigned int) { return pool.alloc(); }
+	static void operator delete(void *p) { pool.free(p); }
 };
 
 class Task {
@@ -89,51 +63,14 @@ public:
 	const bool &running = _running;
 	const int &level = _level, &priority = _priority;
 	TaskQueue *queue = nullptr;
+	Arena *arena = nullptr; // operator new の確保先 (nullptr ならカーネル共通)
+	ListHook<Task> taskHook; // 全タスクのリスト
+	ListHook<Task> runHook;  // 動いているレベルの実行リスト
 
 	friend class TaskSwitcher;
 	friend void IntHandler07(int *esp); // FPU
 	template <typename ...Args>
-	Task(const string &name_, int level_, int priority_, void (*mainLoop)(Args...), int args[] = {}) : _name(name_) {
-		// GDT に登録
-		selector = (kTaskGDT0 + TaskSwitcher::taskCount) * 8;
-		SetSegmentDescriptor((SegmentDescriptor *)kAdrGdt + kTaskGDT0 + TaskSwitcher::taskCount, 103, (int)&tss, kArTss32);
-		++TaskSwitcher::taskCount;
-		
-		// 64KB のスタック確保
-		stack = reinterpret_cast<int>(malloc4k(64 * 1024));
-		
-		// Task State Segment の設定
-		tss.eip = reinterpret_cast<int>(mainLoop);
-		tss.eflags = 0x00000202;
-		tss.eax = 0;
-		tss.ecx = 0;
-		tss.edx = 0;
-		tss.ebx = 0;
-		tss.esp = stack + 64 * 1024 - (sizeof...(Args) + 1) * 4;
-		tss.ebp = 0;
-		tss.esi = 0;
-		tss.edi = 0;
-		tss.es = 1 * 8;//0
-		tss.cs = 2 * 8;
-		tss.ss = 1 * 8;
-		tss.ds = 1 * 8;//0
-		tss.fs = 1 * 8;//0
-		tss.gs = 1 * 8;//0
-		tss.ldtr = 0;
-		tss.iomap = 0x40000000;
-		tss.ss0 = 0;
-		
-		// 引数渡し
-		for (size_t i = 0; i < sizeof...(Args); ++i) {
-			*((int *)(tss.esp + 4 * (i + 1))) = args[i];
-		}
-		
-		// add this pointer to the list of tasks
-		TaskSwitcher::_taskList->push_back(this);
-		
-		// run
-		run(level_, priority_);
-	}
+	Task(const string &name_, int level_, int priority_, void (*mainLoop)(Args...), int args[] = {});
 	template <typename ...Args>
 	Task(const char *name_, int level_, int priority_, int queueSize, void (*mainLoop)(Args...), int args[] = {}) : Task(name_, level_, priority_, mainLoop, args) {
 		queue = new TaskQueue(queueSize, this);
@@ -142,3 +79,81 @@ public:
 	void run(int newLevel, int newPriority);
 	void sleep();
 };
+
+struct TaskLevel {
+	IntrusiveList<Task, &Task::runHook> tasks; // このレベルで動いているタスク
+	Task *now = nullptr; // 今動いているタスク
+};
+
+class Timer;
+
+class TaskSwitcher {
+private:
+	static int nowLevel;
+	static bool levelChanged; // 次回タスクスイッチ時にレベルも変えたほうがいいか
+	static IntrusiveList<Task, &Task::taskHook> _taskList;
+	static TaskLevel _level[];
+	static Task *taskFPU;
+	static Timer *timer;
+	static int taskCount;
+	
+	static void switchTask();
+	static void switchTaskSub();
+	static void add(Task *task);
+	static void remove(Task *task);
+
+public:
+	static const TaskLevel (&level)[MAX_TASKLEVELS];
+	static const IntrusiveList<Task, &Task::taskHook> &taskList;
+
+	friend class Task;
+	friend void IntHandler07(int *esp); // FPU
+	friend void IntHandler20(int *esp); // PIT割り込み
+	static Task *init();
+	static Task *getNowTask();
+};
+
+template <typename ...Args>
+Task::Task(const string &name_, int level_, int priority_, void (*mainLoop)(Args...), int args[]) : _name(name_) {
+	// GDT に登録
+	selector = (kTaskGDT0 + TaskSwitcher::taskCount) * 8;
+	SetSegmentDescriptor((SegmentDescriptor *)kAdrGdt + kTaskGDT0 + TaskSwitcher::taskCount, 103, (int)&tss, kArTss32);
+	++TaskSwitcher::taskCount;
+	
+	// 64KB のスタック確保 (触ったページだけ割り当てられ，下にはガードページがある)
+	stack = reinterpret_cast<int>(ReserveMemory(64 * 1024));
+	if (!stack) OutOfMemory();
+	
+	// Task State Segment の設定
+	tss.cr3 = PageDirectory();
+	tss.eip = reinterpret_cast<int>(mainLoop);
+	tss.eflags = 0x00000202;
+	tss.eax = 0;
+	tss.ecx = 0;
+	tss.edx = 0;
+	tss.ebx = 0;
+	tss.esp = stack + 64 * 1024 - (sizeof...(Args) + 1) * 4;
+	tss.ebp = 0;
+	tss.esi = 0;
+	tss.edi = 0;
+	tss.es = 1 * 8;//0
+	tss.cs = 2 * 8;
+	tss.ss = 1 * 8;
+	tss.ds = 1 * 8;//0
+	tss.fs = 1 * 8;//0
+	tss.gs = 1 * 8;//0
+	tss.ldtr = 0;
+	tss.iomap = 0x40000000;
+	tss.ss0 = 0;
+	
+	// 引数渡し
+	for (size_t i = 0; i < sizeof...(Args); ++i) {
+		*((int *)(tss.esp + 4 * (i + 1))) = args[i];
+	}
+	
+	// add this pointer to the list of tasks
+	TaskSwitcher::_taskList.push_back(*this);
+	
+	// run
+	run(level_, priority_);
+}
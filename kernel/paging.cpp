@@ -0,0 +1,218 @@
+#include "../headers.h"
+
+static unsigned int *pageDirectory;
+static unsigned int reserveMap[(kVirtualEnd - kVirtualBase) / kVirtualChunk / 32]; // 使用中の予約単位
+static TSS32 pageFaultTss;
+static bool largePages;    // 4MB ページが使えるか
+static bool writeCombining; // PAT で WC が使えるか
+
+static inline void invalidatePage(unsigned int addr) {
+	asm volatile("invlpg (%0)" : : "r"(addr) : "memory");
+}
+
+static inline unsigned int cpuidFeatures() {
+	unsigned int a, b, c, d;
+	asm volatile("cpuid" : "=a"(a), "=b"(b), "=c"(c), "=d"(d) : "a"(1));
+	return d;
+}
+
+// 0 で埋めたページを1枚もらう
+static unsigned int *allocZeroPage() {
+	unsigned int *page = (unsigned int *)AllocPages(1);
+	if (page) {
+		for (int i = 0; i < kPageSize / 4; ++i) {
+			page[i] = 0;
+		}
+	}
+	return page;
+}
+
+// addr のページテーブルエントリ (create なら無いページテーブルを作る)
+static unsigned int *pageEntry(unsigned int addr, bool create) {
+	unsigned int &pde = pageDirectory[addr >> 22];
+	if (pde & kPdeLarge) return nullptr; // 4MB ページにはページテーブルが無い
+	if (!(pde & kPtePresent)) {
+		if (!create) return nullptr;
+		unsigned int *table = allocZeroPage();
+		if (!table) return nullptr;
+		pde = (unsigned int)table | kPteWrite | kPtePresent;
+	}
+	return (unsigned int *)(pde & 0xfffff000) + ((addr >> 12) & 0x3ff);
+}
+
+void PagingInit() {
+	pageDirectory = allocZeroPage();
+
+	// 4MB ページと PAT が使えるか
+	unsigned int features = cpuidFeatures();
+	if (features & kCpuidPse) {
+		asm volatile("movl %%cr4, %%eax; orl %0, %%eax; movl %%eax, %%cr4" : : "i"(kCr4Pse) : "eax");
+		largePages = true;
+	}
+	if (features & kCpuidPat) {
+		// PA1 (PWT = 1) を WT から WC に (ページングを始める前なので古い設定のキャッシュは無い)
+		unsigned int low, high;
+		asm volatile("rdmsr" : "=a"(low), "=d"(high) : "c"(kMsrPat));
+		low = (low & 0xffff00ff) | (kPatWriteCombining << 8);
+		asm volatile("wrmsr" : : "a"(low), "d"(high), "c"(kMsrPat));
+		writeCombining = true;
+	}
+
+	// RAM を恒等写像
+	MapIdentity(0, MemoryEnd());
+
+	// ページフォルトは専用のタスクで受ける (スタックがあふれたタスクのスタックを使わないように)
+	unsigned int stack = (unsigned int)AllocPages(4);
+	pageFaultTss.cr3 = (int)pageDirectory;
+	pageFaultTss.eip = (int)&AsmIntHandler0e;
+	pageFaultTss.eflags = 0x00000002; // 割り込み禁止のまま処理する
+	pageFaultTss.esp = stack + 4 * kPageSize;
+	pageFaultTss.es = 1 * 8;
+	pageFaultTss.cs = 2 * 8;
+	pageFaultTss.ss = 1 * 8;
+	pageFaultTss.ds = 1 * 8;
+	pageFaultTss.fs = 1 * 8;
+	pageFaultTss.gs = 1 * 8;
+	pageFaultTss.ldtr = 0;
+	pageFaultTss.iomap = 0x40000000;
+	SetSegmentDescriptor((SegmentDescriptor *)kAdrGdt + kPageFaultGDT, 103, (int)&pageFaultTss, kArTss32);
+	SetGateDescriptor((GateDescriptor *)kAdrIdt + 0x0e, 0, kPageFaultGDT * 8, kArTaskGate);
+	ReserveFaultPages();
+
+	// ページング開始
+	asm volatile("movl %0, %%cr3" : : "r"(pageDirectory) : "memory");
+	StoreCr0(LoadCr0() | kCr0Paging);
+}
+
+unsigned int PageDirectory() {
+	return (unsigned int)pageDirectory;
+}
+
+bool CanWriteCombine() {
+	return writeCombining;
+}
+
+// [addr, addr + size) を同じ物理アドレスに割り当てる (4MB まるごと入るところは 4MB ページで)
+// cache に kPteWriteCombining を指定すると WC になる
+void MapIdentity(unsigned int addr, unsigned int size, unsigned int cache) {
+	// 残りの大きさで数える (4GB の端まで割り当てると addr + size が 0 に戻るので，終わりのアドレスとは比べない)
+	unsigned int left = size + (addr & 0xfff);
+	addr &= 0xfffff000;
+	if (!writeCombining) cache = 0;
+
+	int e = LoadEflags();
+	Cli();
+	while (left) {
+		unsigned int &pde = pageDirectory[addr >> 22];
+		if (largePages && !(addr & (kLargePageSize - 1)) && left >= kLargePageSize && (!(pde & kPtePresent) || (pde & kPdeLarge))) {
+			pde = addr | kPdeLarge | cache | kPteWrite | kPtePresent;
+			invalidatePage(addr);
+			addr += kLargePageSize;
+			left -= kLargePageSize;
+		} else {
+			unsigned int *pte = pageEntry(addr, true);
+			if (!pte) break;
+			*pte = addr | cache | kPteWrite | kPtePresent;
+			invalidatePage(addr);
+			addr += kPageSize;
+			left -= left < kPageSize ? left : kPageSize;
+		}
+	}
+	StoreEflags(e);
+}
+
+/*
+ * 遅延割り当て
+ *
+ * [ガードページ][中身 ...] の形で 64KB 単位の仮想アドレスを予約し，中身のページは触られるまで物理ページを割り当てない．
+ * 中身の直後は次の予約のガードページか未使用の領域なので，上下どちらにはみ出してもページフォルトになる．
+ */
+
+void *ReserveMemory(unsigned int size) {
+	unsigned int pages = (size + kPageSize - 1) / kPageSize;
+	unsigned int chunks = ((pages + 1) * kPageSize + kVirtualChunk - 1) / kVirtualChunk;
+	const unsigned int total = (kVirtualEnd - kVirtualBase) / kVirtualChunk;
+
+	int e = LoadEflags();
+	Cli();
+	// 空いている予約単位の並びを探す
+	unsigned int start = 0, run = 0;
+	for (unsigned int i = 0; i < total && run < chunks; ++i) {
+		if (reserveMap[i / 32] & (1 << (i % 32))) {
+			run = 0;
+			start = i + 1;
+		} else {
+			++run;
+		}
+	}
+	if (run < chunks) {
+		StoreEflags(e);
+		return nullptr;
+	}
+	for (unsigned int i = start; i < start + chunks; ++i) {
+		reserveMap[i / 32] |= 1 << (i % 32);
+	}
+
+	// ページテーブルを作れなかったら予約を取り消す (null に書くと恒等写像した先頭のページを壊す)
+	unsigned int guard = kVirtualBase + start * kVirtualChunk;
+	for (unsigned int i = 0; i <= pages; ++i) {
+		unsigned int *pte = pageEntry(guard + i * kPageSize, true);
+		if (!pte) {
+			while (i-- > 0) {
+				*pageEntry(guard + i * kPageSize, false) = 0;
+			}
+			for (unsigned int j = start; j < start + chunks; ++j) {
+				reserveMap[j / 32] &= ~(1 << (j % 32));
+			}
+			StoreEflags(e);
+			return nullptr;
+		}
+		*pte = i ? kPteDemandZero : (pages << 12) | kPteGuard;
+	}
+	StoreEflags(e);
+
+	return (void *)(guard + kPageSize);
+}
+
+void ReleaseMemory(void *addr) {
+	if (!addr) return;
+
+	int e = LoadEflags();
+	Cli();
+	unsigned int guard = (unsigned int)addr - kPageSize;
+	unsigned int *pte = pageEntry(guard, false);
+	if (pte && (*pte & kPteGuard)) {
+		unsigned int pages = *pte >> 12;
+		*pte = 0;
+		for (unsigned int i = 1; i <= pages; ++i) {
+			pte = pageEntry(guard + i * kPageSize, false);
+			if (!pte) continue;
+			if (*pte & kPtePresent) {
+				FreePages((void *)(*pte & 0xfffff000));
+				invalidatePage(guard + i * kPageSize);
+			}
+			*pte = 0;
+		}
+		unsigned int start = (guard - kVirtualBase) / kVirtualChunk;
+		unsigned int chunks = ((pages + 1) * kPageSize + kVirtualChunk - 1) / kVirtualChunk;
+		for (unsigned int i = start; i < start + chunks; ++i) {
+			reserveMap[i / 32] &= ~(1 << (i % 32));
+		}
+	}
+	StoreEflags(e);
+}
+
+// ページフォルトの処理 (直せなかったら理由を返す)
+const char *HandlePageFault(unsigned int addr) {
+	unsigned int *pte = pageEntry(addr, false);
+	if (!pte || (*pte & kPtePresent)) return "Page Fault!";
+	if (*pte & kPteGuard) return "Guard Page Fault! (Stack Overflow?)";
+	if (!(*pte & kPteDemandZero)) return "Page Fault!";
+
+	// 確保の途中で起きたフォルトかもしれないので，AllocPages は使わずに取っておいたページから
+	void *page = TakeFaultPage();
+	if (!page) return "Out of Memory!";
+	*pte = (unsigned int)page | kPteWrite | kPtePresent;
+	invalidatePage(addr);
+	return nullptr;
+}
@@ -0,0 +1,36 @@
+/*
+ * ページング
+ */
+
+#pragma once
+
+const unsigned int kPtePresent      = 0x001;
+const unsigned int kPteWrite        = 0x002;
+const unsigned int kPteWriteThrough = 0x008; // PAT の番号の bit0 (PWT)
+const unsigned int kPdeLarge        = 0x080; // 4MB ページ (PS)
+const unsigned int kPteDemandZero   = 0x200; // 未割り当て: 触ったら 0 埋めしたページを割り当てる (P = 0 のときだけ)
+const unsigned int kPteGuard        = 0x400; // ガードページ: 上位 20bit に確保したページ数を入れておく (P = 0)
+const unsigned int kCr0Paging       = 0x80000000;
+const unsigned int kCr4Pse          = 0x00000010;
+const unsigned int kLargePageSize   = 0x400000;
+
+// キャッシュの種類 (PAT の 1 番を WT から WC に書き換えて，PWT だけで選べるようにする)
+const unsigned int kMsrPat               = 0x277;
+const unsigned int kPatWriteCombining    = 0x01;
+const unsigned int kPteWriteCombining    = kPteWriteThrough; // PAT が無ければ無視される
+const unsigned int kCpuidPse             = 1 << 3;
+const unsigned int kCpuidPat             = 1 << 16;
+
+// 遅延割り当て用の仮想アドレス空間 (RAM はこれより下に恒等写像する)
+const unsigned int kVirtualBase  = 0xa0000000;
+const unsigned int kVirtualEnd   = 0xc0000000;
+const unsigned int kVirtualChunk = 0x10000; // 予約の単位 (64KB)
+const int kPageFaultGDT = kLimitGdt / 8;      // ページフォルト処理タスクの TSS (GDT の最後)
+
+void         PagingInit();
+unsigned int PageDirectory();
+bool         CanWriteCombine();
+void         MapIdentity(unsigned int addr, unsigned int size, unsigned int cache = 0);
+void         *ReserveMemory(unsigned int size);
+void         ReleaseMemory(void *addr);
+const char   *HandlePageFault(unsigned int addr);
@@ -1,8 +1,11 @@
-#include <stdio.h>
 #include <pistring.h>
+#include <Format.h>
 #include "../headers.h"
 
-void showSysInfo(Sheet *sht, int benchScore) {
+const unsigned int kLowWatermark = 4 * 1024 * 1024; // これを下回ったら空き容量を赤く表示
+const int kLowMemoryData = -1;
+
+void showSysInfo(Sheet *sht, int benchScore, bool lowMemory) {
 	string str;
 	auto memTotal = MemoryTotal();
 	
@@ -11,33 +14,98 @@ void showSysInfo(Sheet *sht, int benchScore) {
 	sht->fillRect(clearRange, 0xffffff);
 	
 	// Benchmark Result
-	str = to_string(benchScore);
+	char t[80];
+	format(t, "{}"_fmt, benchScore);
 	sht->drawString("Benchmark Score:", Point(2, 2), 0);
-	sht->drawString(str, Point(2 + 8 * 17, 2), 0);
+	sht->drawString(t, Point(2 + 8 * 17, 2), 0);
 	
 	// Memory Information
-	str = "RAM: " + to_string(MemoryTest(0x00400000, 0xbfffffff) / 1024 / 1024) + " MB    FREE: " + to_string(memTotal / 1024 / 1024) + " MB (" + to_string(memTotal) + " Byte)";
-	sht->drawString(str, Point(2, 2 + 16), 0);
+	format(t, "RAM: {} MB    FREE: {} MB ({} Byte)"_fmt, MemorySize() / 1024 / 1024, memTotal / 1024 / 1024, memTotal);
+	sht->drawString(t, Point(2, 2 + 16), lowMemory ? 0xff0000 : 0);
 	
 	// Display Information
-	str = "Resoultion: " + to_string(SheetCtl::resolution.width) + " x " + to_string(SheetCtl::resolution.height) + " (" + to_string(SheetCtl::colorDepth) + "-bit color)";
+	str = "";
+	format(str, "Resoultion: {} x {} ({}-bit color)  FILL: {} -> {} MB/s {}"_fmt, SheetCtl::resolution.width, SheetCtl::resolution.height, SheetCtl::colorDepth,
+		SheetCtl::fillRate[0], SheetCtl::fillRate[1], CanWriteCombine() ? "(WC)" : "(no PAT)");
 	sht->drawString(str, Point(2, 2 + 16 * 2), 0);
 	
+	// Heap Information (断片化率 = 1 - 最大空きブロック / 空き合計)
+	const MemoryStats &heap = HeapStats();
+	unsigned int largest = HeapLargestFree();
+	unsigned int ratio = heap.freeBytes >= 100 ? largest / (heap.freeBytes / 100) : 100;
+	unsigned int frag = ratio < 100 ? 100 - ratio : 0;
+	unsigned int avgScan = heap.allocs ? heap.scans * 100 / heap.allocs : 0;
+	format(t, "HEAP: {} blocks  largest {} KB  frag {}%  scan {}.{:02}/{}"_fmt, heap.freeBlocks, largest / 1024, frag, avgScan / 100, avgScan % 100, heap.maxScan);
+	sht->drawString(t, Point(2, 2 + 16 * 3), 0);
+	
+	// Buddy Information (order ごとの空きブロック数)
+	str = "PAGES:";
+	for (int order = 0; order < kBuddyOrders; ++order) {
+		if (BuddyFreeCount(order)) format(str, " {}K:{}"_fmt, 4 << order, BuddyFreeCount(order));
+	}
+	sht->drawString(str, Point(2, 2 + 16 * 4), 0);
+	
 	// Task List
-	sht->drawString("level priority flag task name", Point(2 + 1, 2 + 16 * 4 + 1), 0);
+	sht->drawString("level priority flag  arena task name", Point(2 + 1, 2 + 16 * 5 + 1), 0);
 	int j = 0;
-	char s[20];
-	for (auto &&task : *TaskSwitcher::taskList) {
-		sprintf(s, "%5d %8d %4s ", task->level, task->priority, task->running ? "(oo)" : "(__)");
-		str = s + task->name;
-		sht->drawString(str, Point(2 + 1, 2 + 16 * 5 + j * 16 + 2), 0);
+	for (auto &&task : TaskSwitcher::taskList) {
+		// arena: タブのタスクが確保しているメモリ (KB)
+		str = "";
+		format(str, "{:5} {:8} {:4} {:6} {}"_fmt, task.level, task.priority, task.running ? "(oo)" : "(__)", task.arena ? task.arena->resident / 1024 : 0, task.name);
+		sht->drawString(str, Point(2 + 1, 2 + 16 * 6 + j * 16 + 2), 0);
 		++j;
 	}
-	sht->drawRect(Rectangle(2, 2 + 16 * 4, sht->frame.size.width - 1 - 1 - 2, 16 + j * 16 + 3), 0);
-	sht->drawLine(Line(3, 2 + 16 * 5 + 1, sht->frame.size.width - 1 - 2, 2 + 16 * 5 + 1), 0);
-	sht->drawLine(Line(3 + 5 * 8 + 3, 2 + 16 * 4 + 1, 3 + 5 * 8 + 3, 2 + 16 * 5 + j * 16 + 2), 0);
-	sht->drawLine(Line(3 + 14 * 8 + 3, 2 + 16 * 4 + 1, 3 + 14 * 8 + 3, 2 + 16 * 5 + j * 16 + 2), 0);
-	sht->drawLine(Line(3 + 19 * 8 + 3, 2 + 16 * 4 + 1, 3 + 19 * 8 + 3, 2 + 16 * 5 + j * 16 + 2), 0);
+	sht->drawRect(Rectangle(2, 2 + 16 * 5, sht->frame.size.width - 1 - 1 - 2, 16 + j * 16 + 3), 0);
+	sht->drawLine(Line(3, 2 + 16 * 6 + 1, sht->frame.size.width - 1 - 2, 2 + 16 * 6 + 1), 0);
+	sht->drawLine(Line(3 + 5 * 8 + 3, 2 + 16 * 5 + 1, 3 + 5 * 8 + 3, 2 + 16 * 6 + j * 16 + 2), 0);
+	sht->drawLine(Line(3 + 14 * 8 + 3, 2 + 16 * 5 + 1, 3 + 14 * 8 + 3, 2 + 16 * 6 + j * 16 + 2), 0);
+	sht->drawLine(Line(3 + 19 * 8 + 3, 2 + 16 * 5 + 1, 3 + 19 * 8 + 3, 2 + 16 * 6 + j * 16 + 2), 0);
+	sht->drawLine(Line(3 + 26 * 8 + 3, 2 + 16 * 5 + 1, 3 + 26 * 8 + 3, 2 + 16 * 6 + j * 16 + 2), 0);
+	
+	// Object Pools
+	int y = 2 + 16 * 6 + j * 16 + 8;
+	sht->drawString("size  inuse   peak   allocs pages  pool", Point(2, y), 0);
+	for (PoolAllocator *pool = PoolList(); pool; pool = pool->next) {
+		y += 16;
+		// テンプレートの中のプールは型名が名前なので長い．最後に書く
+		format(t, "{:4} {:6} {:6} {:8} {:5}  {}"_fmt, pool->size, pool->inuse, pool->peak, pool->allocs, pool->pages, pool->name);
+		sht->drawString(t, Point(2, y), 0);
+	}
+	
+#ifdef HEAP_PROFILE
+	// Heap Profile (呼び出し元は kernel.map で調べる)
+	y += 24;
+	HeapSite sites[8];
+	int n = HeapProfileSites(sites, 8);
+	sht->drawString("call site  live bytes  count", Point(2, y), 0);
+	for (int i = 0; i < n; ++i) {
+		y += 16;
+		format(t, "{:08x} {:11} {:6}"_fmt, sites[i].caller, sites[i].bytes, sites[i].count);
+		sht->drawString(t, Point(2, y), 0);
+	}
+	y += 24;
+	HeapTaskUsage usage[16];
+	n = HeapProfileTasks(usage, 16);
+	sht->drawString("live bytes  count task name", Point(2, y), 0);
+	for (int i = 0; i < n; ++i) {
+		y += 16;
+		str = "";
+		format(str, "{:10} {:6} "_fmt, usage[i].bytes, usage[i].count);
+		bool alive = false;
+		for (auto &&task : TaskSwitcher::taskList) {
+			if (&task == usage[i].task) {
+				str += task.name;
+				alive = true;
+				break;
+			}
+		}
+		if (!alive) str += "(終了したタスク)";
+		sht->drawString(str, Point(2, y), 0);
+	}
+	
+	// 生の記録をデバッグポートへ
+	HeapProfileDump();
+#endif
 	
 	// Refresh the screen
 	sht->refresh(clearRange);
@@ -55,21 +123,28 @@ void SysinfoMain(Tab *tab) {
 	// タイマーセット (1s)
 	timer->set(100);
 	
-	showSysInfo(sht, 0);
+	// 空きが少なくなったら知らせてもらう
+	MemoryWatcher *watcher = new MemoryWatcher();
+	watcher->watermark = kLowWatermark;
+	watcher->queue = task->queue;
+	watcher->data = kLowMemoryData;
+	RegisterMemoryWatcher(watcher);
+	tab->watcher = watcher;
+	
+	showSysInfo(sht, 0, false);
 	
+	int data[8];
 	for (;;) {
 		++count;
-		Cli();
-		if (task->queue->isempty()) {
-			//task->sleep(); ベンチマーク測定のため
-			Sti();
-		} else {
-			int data = task->queue->pop();
-			Sti();
-			if (data == timer->data) {
-				showSysInfo(sht, count - count0);
+		// 届いている分をまとめて取り出す (ベンチマーク測定のため眠らないので，割り込みは止めない)
+		int n = task->queue->pop_n(data, 8);
+		for (int i = 0; i < n; ++i) {
+			if (data[i] == timer->data) {
+				showSysInfo(sht, count - count0, watcher->low);
 				count0 = count;
 				timer->set(100);
+			} else if (data[i] == kLowMemoryData) {
+				showSysInfo(sht, count - count0, true);
 			}
 		}
 	}
@@ -1,5 +1,7 @@
 #include "../headers.h"
 
+ObjectPool<Timer> Timer::pool("Timer");
+
 Timer::Timer(TaskQueue *queue_) : _data(TimerController::count), _queue(queue_) {}
 
 Timer::Timer(TaskQueue *queue_, int data_) : _data(data_), _queue(queue_) {}
@@ -12,25 +14,16 @@ void Timer::set(unsigned int newTimeout) {
 	int e = LoadEflags();
 	Cli();
 	if (!running) {
-		Timer *timer0, *timer1;
 		timeout = newTimeout + TimerController::count; // 絶対時間に変換
 		running = true;
-		timer0 = TimerController::t0;
-	
-		if (timeout <= timer0->timeout) {
-			// 先頭に入る
-			TimerController::t0 = this;
-			next = timer0;
-			TimerController::next = timeout;
-		} else {
-			// this が入る位置を決める
-			do {
-				timer1 = timer0;
-				timer0 = timer0->next;
-			} while (timeout > timer0->timeout);
-			timer1->next = this;
-			next = timer0;
+		
+		// this が入る位置を決める (番兵より後ろには行かない)
+		Timer *timer = TimerController::timers.front();
+		while (timeout > timer->timeout) {
+			timer = TimerController::timers.next(*timer);
 		}
+		TimerController::timers.insert(timer, *this);
+		TimerController::next = TimerController::timers.front()->timeout;
 	}
 	StoreEflags(e);
 }
@@ -39,18 +32,8 @@ bool Timer::cancel() {
 	int e = LoadEflags();
 	Cli();
 	if (running) {
-		if (this == TimerController::t0) {
-			// 先頭だった場合
-			TimerController::t0 = next;
-			TimerController::next = next->timeout;
-		} else {
-			// 1つ前と1つ後をつなげる
-			Timer *timer = TimerController::t0;
-			while (timer->next != this) {
-				timer = timer->next;
-			}
-			timer->next = next;
-		}
+		TimerController::timers.remove(*this);
+		TimerController::next = TimerController::timers.front()->timeout;
 		running = false;
 		StoreEflags(e);
 		return true;
@@ -61,7 +44,7 @@ bool Timer::cancel() {
 
 unsigned int TimerController::count = 0;
 unsigned int TimerController::next = 0xffffffff;
-Timer *TimerController::t0;
+IntrusiveList<Timer, &Timer::hook> TimerController::timers;
 
 void TimerController::init() {
 	// Initialize PIT
@@ -69,11 +52,11 @@ void TimerController::init() {
 	Output8(PIT_CNT0, 0x9c);
 	Output8(PIT_CNT0, 0x2e);
 
-	// Initialize member variables
-	t0 = new Timer(nullptr);
-	t0->timeout = 0xffffffff;
-	t0->running = true;
-	t0->next = nullptr;
+	// Initialize member variables (最後に置く番兵)
+	Timer *sentinel = new Timer(nullptr);
+	sentinel->timeout = 0xffffffff;
+	sentinel->running = true;
+	timers.push_back(*sentinel);
 }
 
 // count_ をリセット (これじゃだめだった)
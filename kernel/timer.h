@@ -10,7 +10,7 @@ const int PIT_CNT0 = 0x0040;
 class Timer {
 private:
 	int _data;
-	Timer *next;
+	ListHook<Timer> hook; // TimerController::timers のつなぎ
 	unsigned int timeout;
 	bool running = false;
 	TaskQueue *_queue;
@@ -26,13 +26,17 @@ public:
 	~Timer();
 	void set(unsigned int newTimeout);
 	bool cancel();
+	
+	static ObjectPool<Timer> pool;
+	static void *operator new(long unsigned int) { return pool.alloc(); }
+	static void operator delete(void *p) { pool.free(p); }
 };
 
 class TimerController {
 private:
 	static unsigned int count;
 	static unsigned int next;
-	static Timer *t0;
+	static IntrusiveList<Timer, &Timer::hook> timers; // タイムアウトが早い順 (最後は番兵)
 
 public:
 	friend class Timer;
@@ -0,0 +1,52 @@
+#include <Format.h>
+
+// 00 から 99 までを2文字ずつ
+static const char kDigitPairs[201] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+unsigned int DecimalLength(unsigned int n) {
+	unsigned int len = 1;
+	for (;;) {
+		if (n < 10) return len;
+		if (n < 100) return len + 1;
+		if (n < 1000) return len + 2;
+		if (n < 10000) return len + 3;
+		n /= 10000;
+		len += 4;
+	}
+}
+
+unsigned int HexLength(unsigned int n) {
+	return n ? (32 - __builtin_clz(n) + 3) / 4 : 1;
+}
+
+// 下の桁から2桁ずつ (割り算は定数なので掛け算になる)
+void WriteDecimal(char *p, unsigned int n, unsigned int len) {
+	p += len;
+	for (; len >= 2; len -= 2) {
+		unsigned int q = n / 100;
+		const char *d = &kDigitPairs[(n - q * 100) * 2];
+		*--p = d[1];
+		*--p = d[0];
+		n = q;
+	}
+	if (len) *--p = '0' + n % 10;
+}
+
+void WriteHex(char *p, unsigned int n, unsigned int len, bool upper) {
+	const char *digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+	p += len;
+	for (; len; --len) {
+		*--p = digits[n & 15];
+		n >>= 4;
+	}
+}
@@ -1,5 +1,7 @@
 #include <SmartPointer.h>
 
+ObjectPool<ReferenceCounter> ReferenceCounter::pool("ReferenceCounter");
+
 void ReferenceCounter::Add() {
 	++count;
 }
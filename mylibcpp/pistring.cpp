@@ -2,6 +2,7 @@
 Created by: PiMaster
 */
 
+#include <string.h>
 #include <pistring.h>
 
 char stroob=0;
@@ -15,50 +16,18 @@ void string::resizedata(unsigned newsize){
 	char* tmp=new char[datasize+newsize];
 	if(data!=nullptr){
 		memcpy(tmp,data,datalen+1);
-		delete[] data;}
+		if(data!=local){
+			delete[] data;}}
 	data=tmp;
 	datasize+=newsize;}
-//doesn't check for memory overlapping
-void* string::memcpy(void* dst,const void* src,unsigned len){
-	if(dst==nullptr || src==nullptr || len==0){
-		return nullptr;}
-	char* d=(char*)dst;
-	char* s=(char*)src;
-	unsigned n=0;
-	while(n<len){
-		*d=*s;
-		++d;
-		++s;
-		++n;}
-	return dst;}
-//does check for memory overlapping
-void* string::memmove(void* dst,const void* src,unsigned len){
-	if(dst==nullptr || src==nullptr || len==0){
-		return nullptr;}
-	char* d=(char*)dst;
-	char* s=(char*)src;
-	unsigned n=0;
-	//if dst is potentially overlapping src
-	if(d>s){
-		d+=len-1;
-		s+=len-1;
-		while(n<len){
-			*d=*s;
-			--d;
-			--s;
-			++n;}}
+void string::initdata(unsigned len){
+	if(len<localsize){
+		data=local;
+		datasize=localsize;}
 	else{
-		while(n<len){
-			*d=*s;
-			++d;
-			++s;
-			++n;}}
-	return dst;}
-unsigned string::strlen(const char* str) const{
-	unsigned x=0;
-	while(str[x]!=0){
-		++x;}
-	return x;}
+		data=new char[len+minbuffsize];
+		datasize=len+minbuffsize;}
+	datalen=len;}
 //functions that are called by other functions
 //count the number of occurrences of str
 unsigned string::countstr(const char* str,unsigned size) const{
@@ -143,56 +112,56 @@ int string::compareistr(const char* str,unsigned first,unsigned last,unsigned st
 		return 0;}
 	return c1-c2;}
 string::string(){
-	data=new char[minbuffsize];
-	data[0]=0;
-	datasize=minbuffsize;
-	datalen=0;}
+	initdata(0);
+	data[0]=0;}
 string::string(const char* str){
 	unsigned s=strlen(str);
-	data=new char[s+minbuffsize];
-	memcpy(data,str,s+1);
-	datasize=s+minbuffsize;
-	datalen=s;}
+	initdata(s);
+	memcpy(data,str,s+1);}
 string::string(const char *str, size_t len) {
-	data = new char[len + minbuffsize];
-	memcpy(data, str, len + 1);
-	datasize = len + minbuffsize;
-	datalen = len;
+	initdata(len);
+	memcpy(data, str, len);
+	data[len] = 0;
 }
 string::string(size_t n, char c) {
 	size_t i;
-	data = new char[n + minbuffsize];
+	initdata(n);
 	for (i = 0; i < n; ++i) {
 		data[i] = c;
 	}
 	data[i] = 0;
-	datasize = n + minbuffsize;
-	datalen = n;
 }
 string::string(const string& str){
-	data=new char[str.datasize];
-	memcpy(data,str.data,str.datalen+1);
-	datasize=str.datasize;
-	datalen=str.datalen;}
+	initdata(str.datalen);
+	memcpy(data,str.data,str.datalen+1);}
+string::string(string&& str){
+	if(str.data==str.local){
+		//short strings are simply copied
+		initdata(str.datalen);
+		memcpy(data,str.data,str.datalen+1);}
+	else{
+		data=str.data;
+		datasize=str.datasize;
+		datalen=str.datalen;
+		str.initdata(0);
+		str.data[0]=0;}}
 string::string(const string& str, unsigned pos, unsigned len){
 	if (pos > str.datalen) {
-		data = new char[minbuffsize];
+		initdata(0);
 		data[0] = 0;
-		datasize = minbuffsize;
-		datalen = 0;
 	} else {
 		if (pos + len > str.datalen) {
 			len = str.datalen - pos;
 		}
 		
-		data = new char[str.datasize - pos];
-		memcpy(data, str.data + pos, len + 1);
-		datasize = str.datasize - pos;
-		datalen = len;
+		initdata(len);
+		memcpy(data, str.data + pos, len);
+		data[len] = 0;
 	}
 }
 string::~string(){
-	delete[] data;}
+	if(data!=local){
+		delete[] data;}}
 string& string::operator=(const char c){
 	if(2>datasize){
 		resizedata(minbuffsize+1-datasize);}
@@ -208,11 +177,25 @@ string& string::operator=(const char* str){
 	datalen=s;
 	return *this;}
 string& string::operator=(const string& str){
+	//resizedata copies datalen+1 bytes of the old data, so grow before updating datalen
+	if(str.datalen+1>datasize){
+		resizedata((str.datalen<<1)-datasize);}
 	datalen=str.datalen;
-	if(datalen+1>datasize){
-		resizedata((datalen<<1)-datasize);}
 	memcpy(data,str.data,datalen+1);
 	return *this;}
+string& string::operator=(string&& str){
+	if(this==&str){
+		return *this;}
+	if(str.data==str.local){
+		return *this=str;}
+	if(data!=local){
+		delete[] data;}
+	data=str.data;
+	datasize=str.datasize;
+	datalen=str.datalen;
+	str.initdata(0);
+	str.data[0]=0;
+	return *this;}
 string& string::operator+=(const char c){
 	if(datalen+2>datasize){
 		resizedata(minbuffsize);}
@@ -233,6 +216,13 @@ string& string::operator+=(const string& str){
 	memcpy(data+datalen,str.data,str.datalen+1);
 	datalen+=str.datalen;
 	return *this;}
+char* string::extend(unsigned n){
+	if(datalen+n+1>datasize){
+		resizedata(n<<1);}
+	char* p=data+datalen;
+	datalen+=n;
+	data[datalen]=0;
+	return p;}
 void string::clear(){
 	data[0]=0;}
 unsigned string::insert(unsigned pos,unsigned n,const char c){
@@ -302,10 +292,13 @@ unsigned string::rfind(const string& str,unsigned n,unsigned start) const{
 	return rfindstr(str,strlen(str),start,n);}
 //reserve
 int string::reserve(const unsigned newsize){
-	unsigned size=(newsize>datasize?newsize:datasize);
+	if(newsize<=datasize){
+		return datasize;}
+	unsigned size=newsize;
 	char* tmp=new char[size];
-	memcpy(tmp,data,datalen);
-	delete[] data;
+	memcpy(tmp,data,datalen+1);
+	if(data!=local){
+		delete[] data;}
 	data=tmp;
 	datasize=size;
 	return size;}
@@ -462,76 +455,66 @@ string::const_iterator string::end() const{
 
 //I couldn't use the ones defined in the string class, so I made an obscurely named namespace to hide them
 bool strexternalfuncs::isequal(const char* str1,const char* str2,unsigned len1,unsigned len2){
-	if(len1!=len2){
-		return false;}
-	unsigned pos=0;
-	while(pos<len1){
-		if(str1[pos]!=str2[pos]){
-			return false;}
-		++pos;}
-	return true;}
+	return len1==len2 && memcmp(str1,str2,len1)==0;}
 unsigned strexternalfuncs::strlen(const char* str){
-	unsigned x = 0;
-	while(str[x]!=0){
-		++x;}
-	return x;}
+	return ::strlen(str);}
 
 //equal
 bool operator==(const string& str1,const string& str2){
 	return (str1.comparestr(str2.data,0,str1.datalen,0,str2.datalen)==0);}
 
 bool operator==(const string& str1,const char* str2){
-	return (str1.comparestr(str2,0,str1.datalen,0,str1.strlen(str2))==0);}
+	return (str1.comparestr(str2,0,str1.datalen,0,strlen(str2))==0);}
 
 bool operator==(const char* str1,const string& str2){
-	return (str2.comparestr(str1,0,str2.datalen,0,str2.strlen(str1))==0);}
+	return (str2.comparestr(str1,0,str2.datalen,0,strlen(str1))==0);}
 
 //not equal
 bool operator!=(const string& str1,const string& str2){
 	return (str1.comparestr(str2.data,0,str1.datalen,0,str2.datalen)!=0);}
 
 bool operator!=(const string& str1,const char* str2){
-	return (str1.comparestr(str2,0,str1.datalen,0,str1.strlen(str2))!=0);}
+	return (str1.comparestr(str2,0,str1.datalen,0,strlen(str2))!=0);}
 
 bool operator!=(const char* str1,const string& str2){
-	return (str2.comparestr(str1,0,str2.datalen,0,str2.strlen(str1))!=0);}
+	return (str2.comparestr(str1,0,str2.datalen,0,strlen(str1))!=0);}
 
 //greater than
 bool operator>(const string& str1,const string& str2){
 	return (str1.comparestr(str2.data,0,str1.datalen,0,str2.datalen)>0);}
 
 bool operator>(const string& str1,const char* str2){
-	return (str1.comparestr(str2,0,str1.datalen,0,str1.strlen(str2))>0);}
+	return (str1.comparestr(str2,0,str1.datalen,0,strlen(str2))>0);}
 
 bool operator>(const char* str1,const string& str2){
-	return (str2.comparestr(str1,0,str2.datalen,0,str2.strlen(str1))>0);}
+	return (str2.comparestr(str1,0,str2.datalen,0,strlen(str1))>0);}
 
 //less than
 bool operator<(const string& str1,const string& str2){
 	return (str1.comparestr(str2.data,0,str1.datalen,0,str2.datalen)<0);}
 
 bool operator<(const string& str1,const char* str2){
-	return (str1.comparestr(str2,0,str1.datalen,0,str1.strlen(str2))<0);}
+	return (str1.comparestr(str2,0,str1.datalen,0,strlen(str2))<0);}
 
 bool operator<(const char* str1,const string& str2){
-	return (str2.comparestr(str1,0,str2.datalen,0,str2.strlen(str1))<0);}
+	return (str2.comparestr(str1,0,str2.datalen,0,strlen(str1))<0);}
 
 //greater than or equal to
 bool operator>=(const string& str1,const string& str2){
 	return (str1.comparestr(str2.data,0,str1.datalen,0,str2.datalen)>=0);}
 
 bool operator>=(const string& str1,const char* str2){
-	return (str1.comparestr(str2,0,str1.datalen,0,str1.strlen(str2))>=0);}
+	return (str1.comparestr(str2,0,str1.datalen,0,strlen(str2))>=0);}
 
 bool operator>=(const char* str1,const string& str2){
-	return (str2.comparestr(str1,0,str2.datalen,0,str2.strlen(str1))>=0);}
+	return (str2.comparestr(str1,0,str2.datalen,0,strlen(str1))>=0);}
 
 //less than or equal to
 bool operator<=(const string& str1,const string& str2){
 	return (str1.comparestr(str2.data,0,str1.datalen,0,str2.datalen)<=0);}
 
 bool operator<=(const string& str1,const char* str2){
-	return (str1.comparestr(str2,0,str1.datalen,0,str1.strlen(str2))<=0);}
+	return (str1.comparestr(str2,0,str1.datalen,0,strlen(str2))<=0);}
 
 bool operator<=(const char* str1,const string& str2){
-	return (str2.comparestr(str1,0,str2.datalen,0,str2.strlen(str1))<=0);}
+	return (str2.comparestr(str1,0,str2.datalen,0,strlen(str1))<=0);}
@@ -0,0 +1,296 @@
+/*
+ * Format
+ *
+ * sprintf の代わり．書式の {} の所に引数を順に書き込む．
+ *
+ *   char s[9];
+ *   format(s, "{:02}:{:02} PM"_fmt, hour, minute); // 入りきらない分は捨てて，必ず '\0' で終わる
+ *   format(str, "RAM: {} MB"_fmt, size);           // string には後ろに足していく
+ *
+ * {} の中身は [:][<][0][幅][x|X]．< は左寄せ，0 は 0 埋め，x/X は16進．{{ と }} は { と }．
+ * 書式は _fmt で型にしておくので，書式が壊れている・{} と引数の数が合わない・整数以外に x を付けた，はコンパイルエラーになる．
+ * 引数は型ごとに書き方を選ぶので，va_arg のように型を取り違えて読むことはない (書けない型もコンパイルエラー)．
+ * 数字は2桁ずつ表から引いて，書き込み先に直接書く．
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <StringView.h>
+
+// 数字の書き込み (中身は mylibcpp/Format.cpp)
+unsigned int DecimalLength(unsigned int n);
+unsigned int HexLength(unsigned int n);
+// p から len 桁で n を書く (len が桁数より多ければ上の桁は 0)
+void WriteDecimal(char *p, unsigned int n, unsigned int len);
+void WriteHex(char *p, unsigned int n, unsigned int len, bool upper);
+
+// {} 1つ分の書き方
+struct FormatSpec {
+	unsigned int width = 0;
+	bool left = false, zero = false, hex = false, upper = false;
+};
+
+// "..."_fmt で作る，書式を型にしたもの
+template <char ...Cs>
+struct FormatString {
+	static constexpr char str[] = { Cs..., '\0' };
+};
+template <char ...Cs>
+constexpr char FormatString<Cs...>::str[];
+
+template <typename C, C ...Cs>
+constexpr FormatString<Cs...> operator""_fmt() {
+	static_assert(sizeof(C) == 1, "format: 書式は char の文字列で書く");
+	return {};
+}
+
+// 書式の中の位置は添字で返す (-1 は書式が壊れている)
+struct FormatParser {
+	// i から始まる文字列の終わり (次の {} の '{' か '\0' の位置．対になっていない '}' があれば -1)
+	static constexpr int literalEnd(const char *s, int i) {
+		for (;;) {
+			if (s[i] == '\0') return i;
+			if (s[i] == '{' && s[i + 1] != '{') return i;
+			if (s[i] == '}' && s[i + 1] != '}') return -1;
+			i += (s[i] == '{' || s[i] == '}') ? 2 : 1;
+		}
+	}
+
+	// [i, e) に {{ か }} があるか
+	static constexpr bool hasBrace(const char *s, int i, int e) {
+		for (; i < e; ++i) {
+			if (s[i] == '{' || s[i] == '}') return true;
+		}
+		return false;
+	}
+
+	// i は '{' の次．'}' の次の位置を返す
+	static constexpr int parseSpec(const char *s, int i, FormatSpec &spec) {
+		if (s[i] == ':') {
+			++i;
+			if (s[i] == '<') {
+				spec.left = true;
+				++i;
+			}
+			if (s[i] == '0') {
+				spec.zero = true;
+				++i;
+			}
+			while ('0' <= s[i] && s[i] <= '9') {
+				spec.width = spec.width * 10 + (s[i++] - '0');
+			}
+			if (s[i] == 'x' || s[i] == 'X') {
+				spec.hex = true;
+				spec.upper = s[i] == 'X';
+				++i;
+			}
+		}
+		return s[i] == '}' ? i + 1 : -1;
+	}
+	static constexpr FormatSpec specAt(const char *s, int i) {
+		FormatSpec spec;
+		parseSpec(s, i, spec);
+		return spec;
+	}
+	static constexpr int specEnd(const char *s, int i) {
+		FormatSpec spec;
+		return parseSpec(s, i, spec);
+	}
+
+	// {} の数
+	static constexpr int count(const char *s) {
+		int n = 0;
+		for (int i = 0;; ++n) {
+			i = literalEnd(s, i);
+			if (i < 0) return -1;
+			if (!s[i]) return n;
+			i = specEnd(s, i + 1);
+			if (i < 0) return -1;
+		}
+	}
+
+	// x を付けた {} に整数以外が来ていないか (integer[k] が k 番目の引数，n 個)
+	static constexpr bool hexOk(const char *s, const bool *integer, int n) {
+		for (int i = 0, k = 0; k < n; ++k) {
+			i = literalEnd(s, i);
+			if (i < 0 || !s[i]) return true;
+			FormatSpec spec;
+			i = parseSpec(s, i + 1, spec);
+			if (i < 0) return true;
+			if (spec.hex && !integer[k]) return false;
+		}
+		return true;
+	}
+	template <typename ...Args>
+	static constexpr bool hexOk(const char *s);
+};
+
+/*
+ * 書き込み先
+ * put/fill で書き足し，claim(n) は n 文字書ける場所を返す (呼んだ側がそこに書く．入りきらなければ nullptr)．
+ */
+template <typename Out>
+struct FormatWriter {
+	static_assert(sizeof(Out) == 0, "format: ここには書き込めない");
+};
+
+// 固定長のバッファ (入りきらない分は捨てる．途中で切れる数字は丸ごと捨てる)
+template <size_t N>
+struct FormatWriter<char[N]> {
+	char *p, *const start, *end;
+
+	explicit FormatWriter(char (&buf)[N]) : p(buf), start(buf), end(buf + N - 1) {}
+	void put(const char *s, unsigned int n) {
+		if (n > (unsigned int)(end - p)) n = end - p;
+		for (unsigned int i = 0; i < n; ++i) p[i] = s[i];
+		p += n;
+	}
+	void fill(char c, unsigned int n) {
+		if (n > (unsigned int)(end - p)) n = end - p;
+		for (unsigned int i = 0; i < n; ++i) p[i] = c;
+		p += n;
+	}
+	char *claim(unsigned int n) {
+		if (n > (unsigned int)(end - p)) {
+			end = p; // ここで打ち切る
+			return nullptr;
+		}
+		p += n;
+		return p - n;
+	}
+	unsigned int finish() {
+		*p = '\0';
+		return p - start;
+	}
+};
+
+/*
+ * 引数の書き方
+ * integer は x を付けられるかどうか
+ */
+template <typename T>
+struct FormatArg {
+	static_assert(sizeof(T) == 0, "format: この型は書けない");
+};
+
+struct FormatUnsigned {
+	static constexpr bool integer = true;
+	template <typename W>
+	static void write(W &w, const FormatSpec &spec, unsigned int n, bool minus = false) {
+		unsigned int digits = spec.hex ? HexLength(n) : DecimalLength(n);
+		unsigned int len = digits + minus;
+		unsigned int pad = spec.width > len ? spec.width - len : 0;
+		unsigned int lead = spec.left ? 0 : pad;
+		// 前の埋めと符号と数字はまとめて場所を取る (入りきらなければ埋めごと捨てる)
+		char *p = w.claim(lead + len);
+		if (!p) return;
+		if (!spec.zero) {
+			for (unsigned int i = 0; i < lead; ++i) *p++ = ' ';
+		}
+		if (minus) *p++ = '-';
+		if (spec.zero) {
+			for (unsigned int i = 0; i < lead; ++i) *p++ = '0';
+		}
+		if (spec.hex) {
+			WriteHex(p, n, digits, spec.upper);
+		} else {
+			WriteDecimal(p, n, digits);
+		}
+		if (spec.left) w.fill(' ', pad);
+	}
+};
+struct FormatSigned {
+	static constexpr bool integer = true;
+	template <typename W>
+	static void write(W &w, const FormatSpec &spec, int n) {
+		if (n < 0 && !spec.hex) {
+			FormatUnsigned::write(w, spec, 0u - (unsigned int)n, true);
+		} else {
+			FormatUnsigned::write(w, spec, n);
+		}
+	}
+};
+struct FormatText {
+	static constexpr bool integer = false;
+	template <typename W>
+	static void write(W &w, const FormatSpec &spec, string_view s) {
+		unsigned int pad = spec.width > s.length() ? spec.width - s.length() : 0;
+		if (!spec.left) w.fill(' ', pad);
+		w.put(s.data(), s.length());
+		if (spec.left) w.fill(' ', pad);
+	}
+};
+struct FormatChar {
+	static constexpr bool integer = false;
+	template <typename W>
+	static void write(W &w, const FormatSpec &spec, char c) {
+		FormatText::write(w, spec, string_view(&c, 1));
+	}
+};
+
+// char は文字，signed char と unsigned char は数として書く
+template <> struct FormatArg<char> : FormatChar {};
+template <> struct FormatArg<signed char> : FormatSigned {};
+template <> struct FormatArg<short> : FormatSigned {};
+template <> struct FormatArg<int> : FormatSigned {};
+template <> struct FormatArg<long> : FormatSigned {};
+template <> struct FormatArg<unsigned char> : FormatUnsigned {};
+template <> struct FormatArg<unsigned short> : FormatUnsigned {};
+template <> struct FormatArg<unsigned int> : FormatUnsigned {};
+template <> struct FormatArg<unsigned long> : FormatUnsigned {};
+template <> struct FormatArg<const char *> : FormatText {};
+template <> struct FormatArg<char *> : FormatText {};
+template <size_t N> struct FormatArg<char[N]> : FormatText {};
+template <> struct FormatArg<string_view> : FormatText {};
+
+template <typename ...Args>
+constexpr bool FormatParser::hexOk(const char *s) {
+	const bool integer[] = { false, FormatArg<Args>::integer... };
+	return hexOk(s, integer + 1, sizeof...(Args));
+}
+
+/*
+ * 書式は型なので，{} の位置も書き方もコンパイル時に決まっている．
+ * 実行時は間の文字列をそのまま書いて，引数を1つずつ書くだけ．
+ */
+template <typename Fmt, int Begin, int End, typename W>
+void FormatLiteral(W &w) {
+	constexpr bool brace = FormatParser::hasBrace(Fmt::str, Begin, End);
+	if (!brace) {
+		w.put(Fmt::str + Begin, End - Begin);
+		return;
+	}
+	for (const char *s = Fmt::str + Begin, *e = Fmt::str + End; s < e;) {
+		const char *t = s;
+		while (t < e && *t != '{' && *t != '}') ++t;
+		w.put(s, t - s);
+		if (t == e) break;
+		w.put(t, 1); // {{ か }} の1文字目
+		s = t + 2;
+	}
+}
+template <typename Fmt, int Pos, typename W>
+void FormatNext(W &w) {
+	FormatLiteral<Fmt, Pos, FormatParser::literalEnd(Fmt::str, Pos)>(w);
+}
+template <typename Fmt, int Pos, typename W, typename T, typename ...Rest>
+void FormatNext(W &w, const T &arg, const Rest &...rest) {
+	constexpr int open = FormatParser::literalEnd(Fmt::str, Pos);
+	constexpr FormatSpec spec = FormatParser::specAt(Fmt::str, open + 1);
+	FormatLiteral<Fmt, Pos, open>(w);
+	FormatArg<T>::write(w, spec, arg);
+	FormatNext<Fmt, FormatParser::specEnd(Fmt::str, open + 1)>(w, rest...);
+}
+
+// 書いた文字数を返す
+template <typename Out, char ...Cs, typename ...Args>
+unsigned int format(Out &out, FormatString<Cs...>, const Args &...args) {
+	typedef FormatString<Cs...> Fmt;
+	static_assert(FormatParser::count(Fmt::str) >= 0, "format: 書式が壊れている");
+	static_assert(FormatParser::count(Fmt::str) == sizeof...(Args), "format: {} の数と引数の数が合わない");
+	static_assert(FormatParser::hexOk<Args...>(Fmt::str), "format: x は整数にしか付けられない");
+	FormatWriter<Out> w(out);
+	FormatNext<Fmt, 0>(w, args...);
+	return w.finish();
+}
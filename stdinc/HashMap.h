@@ -0,0 +1,295 @@
+/*
+ * HashMap
+ *
+ * 開番地法 (Robin Hood ハッシュ) の連想配列．
+ * 探す位置からの距離が短い要素を後ろへ押し出しながら入れるので，どの要素も探す位置の近くに並び，
+ * 無いキーも距離が自分より短い要素に出会った時点で打ち切れる．消すときは後ろの要素を1つずつ詰める．
+ *
+ * 例外は使わず，見つからなければ find が nullptr を返す．
+ * キーは hashOf と == が定義されていれば何でもよく，string のキーは string_view や C 文字列のまま探せる．
+ * 確保し直すと要素の場所が変わるので，find で得たポインタを insert の後まで持ち続けないこと．
+ */
+
+#pragma once
+
+#include <Utility.h>
+#include <StringView.h>
+#include <pistring.h>
+
+// FNV-1a
+inline unsigned int hashOf(string_view str) {
+	unsigned int h = 2166136261u;
+	for (char c : str) {
+		h = (h ^ (unsigned char)c) * 16777619u;
+	}
+	return h;
+}
+inline unsigned int hashOf(const string &str) {
+	return hashOf(string_view(str));
+}
+inline unsigned int hashOf(const char *str) {
+	return hashOf(string_view(str));
+}
+// 整数とポインタは掛け算で上位ビットまで混ぜる (位置は上位ビットから取る)
+inline unsigned int hashOf(unsigned int n) {
+	return n * 2654435761u;
+}
+inline unsigned int hashOf(int n) {
+	return hashOf((unsigned int)n);
+}
+inline unsigned int hashOf(const void *p) {
+	return hashOf((unsigned int)(unsigned long)p);
+}
+
+template <typename K, typename V>
+class HashMap {
+public:
+	struct Entry {
+		K key;
+		V value;
+	};
+
+private:
+	static const int kMinCapacity = 8;
+
+	Entry *entries = nullptr;
+	unsigned short *distances = nullptr; // 探す位置からの距離 + 1 (0 なら空き)
+	int _size = 0, _capacity = 0;        // _capacity は 2 の累乗
+	int shift = 32;                      // ハッシュ値の上位 log2(_capacity) ビットを位置にする
+
+	int home(unsigned int hash) const {
+		return shift < 32 ? hash >> shift : 0;
+	}
+
+	// key の入っている位置 (無ければ -1)
+	template <typename Q>
+	int indexOf(const Q &key) const {
+		if (!_size) return -1;
+		int mask = _capacity - 1;
+		int i = home(hashOf(key));
+		for (int d = 1; d <= distances[i]; ++d) {
+			if (entries[i].key == key) return i;
+			i = (i + 1) & mask;
+		}
+		return -1;
+	}
+
+	// 入っていないとわかっている要素を入れる (距離が足りなくなったら false)
+	bool place(Entry &&entry, Entry *&placed) {
+		int mask = _capacity - 1;
+		int i = home(hashOf(entry.key));
+		int d = 1;
+		placed = nullptr;
+		for (;;) {
+			if (!distances[i]) {
+				new (entries + i) Entry(move(entry));
+				distances[i] = d;
+				if (!placed) placed = entries + i;
+				++_size;
+				return true;
+			}
+			if (distances[i] < d) {
+				// 自分より探す位置に近い要素を押し出して，その続きを入れる
+				Entry tmp(move(entries[i]));
+				entries[i] = move(entry);
+				entry = move(tmp);
+				int t = distances[i];
+				distances[i] = d;
+				d = t;
+				if (!placed) placed = entries + i;
+			}
+			i = (i + 1) & mask;
+			if (++d > 0xffff) return false;
+		}
+	}
+
+	void rehash(int newCapacity) {
+		Entry *oldEntries = entries;
+		unsigned short *oldDistances = distances;
+		int oldCapacity = _capacity;
+
+		entries = static_cast<Entry *>(operator new(newCapacity * sizeof(Entry)));
+		distances = new unsigned short[newCapacity];
+		for (int i = 0; i < newCapacity; ++i) {
+			distances[i] = 0;
+		}
+		_capacity = newCapacity;
+		_size = 0;
+		shift = 32;
+		for (int n = newCapacity; n > 1; n >>= 1) {
+			--shift;
+		}
+
+		Entry *placed;
+		for (int i = 0; i < oldCapacity; ++i) {
+			if (oldDistances[i]) {
+				place(move(oldEntries[i]), placed);
+				oldEntries[i].~Entry();
+			}
+		}
+		operator delete(oldEntries);
+		delete[] oldDistances;
+	}
+
+	// あと1つ入るようにする (7/8 まで埋める)
+	void grow() {
+		if (!_capacity) {
+			rehash(kMinCapacity);
+		} else if ((_size + 1) * 8 > _capacity * 7) {
+			rehash(_capacity * 2);
+		}
+	}
+
+	Entry *insertNew(Entry &&entry) {
+		grow();
+		Entry *placed;
+		if (place(move(entry), placed)) return placed;
+
+		// 距離があふれた (ハッシュが偏っている) ので，広げて押し出された要素を入れ直す
+		K key(placed ? placed->key : entry.key);
+		do {
+			rehash(_capacity * 2);
+		} while (!place(move(entry), placed));
+		return entries + indexOf(key);
+	}
+
+public:
+	HashMap() = default;
+	HashMap(const HashMap &) = delete;
+	HashMap &operator=(const HashMap &) = delete;
+	HashMap(HashMap &&map) : entries(map.entries), distances(map.distances), _size(map._size), _capacity(map._capacity), shift(map.shift) {
+		map.entries = nullptr;
+		map.distances = nullptr;
+		map._size = map._capacity = 0;
+		map.shift = 32;
+	}
+	~HashMap() {
+		clear();
+		operator delete(entries);
+		delete[] distances;
+	}
+
+	int size() const {
+		return _size;
+	}
+	bool empty() const {
+		return !_size;
+	}
+
+	// n 個まで確保し直さずに入るようにする
+	void reserve(int n) {
+		int capacity = kMinCapacity;
+		while (n * 8 > capacity * 7) {
+			capacity *= 2;
+		}
+		if (capacity > _capacity) rehash(capacity);
+	}
+
+	// 無ければ nullptr
+	template <typename Q>
+	V *find(const Q &key) {
+		int i = indexOf(key);
+		return i < 0 ? nullptr : &entries[i].value;
+	}
+	template <typename Q>
+	const V *find(const Q &key) const {
+		int i = indexOf(key);
+		return i < 0 ? nullptr : &entries[i].value;
+	}
+	template <typename Q>
+	bool contains(const Q &key) const {
+		return indexOf(key) >= 0;
+	}
+
+	// 入れる (既にあれば値を置き換える)
+	V &insert(const K &key, V value) {
+		int i = indexOf(key);
+		if (i >= 0) {
+			entries[i].value = move(value);
+			return entries[i].value;
+		}
+		return insertNew(Entry{ key, move(value) })->value;
+	}
+
+	// 無ければ V() を入れる
+	V &operator[](const K &key) {
+		int i = indexOf(key);
+		if (i >= 0) return entries[i].value;
+		return insertNew(Entry{ key, V() })->value;
+	}
+
+	template <typename Q>
+	bool erase(const Q &key) {
+		int i = indexOf(key);
+		if (i < 0) return false;
+
+		// 後ろの要素を1つずつ前に詰める (探す位置にいる要素か空きまで)
+		int mask = _capacity - 1;
+		int next = (i + 1) & mask;
+		while (distances[next] > 1) {
+			entries[i] = move(entries[next]);
+			distances[i] = distances[next] - 1;
+			i = next;
+			next = (next + 1) & mask;
+		}
+		entries[i].~Entry();
+		distances[i] = 0;
+		--_size;
+		return true;
+	}
+
+	void clear() {
+		for (int i = 0; i < _capacity; ++i) {
+			if (distances[i]) {
+				entries[i].~Entry();
+				distances[i] = 0;
+			}
+		}
+		_size = 0;
+	}
+
+	// 入っている要素を順不同でたどる
+	struct iterator {
+	private:
+		const HashMap *map;
+		int i;
+
+		void skip() {
+			while (i < map->_capacity && !map->distances[i]) ++i;
+		}
+
+	public:
+		friend class HashMap;
+		iterator &operator++() {
+			++i;
+			skip();
+			return *this;
+		}
+		bool operator==(const iterator &it) const {
+			return i == it.i;
+		}
+		bool operator!=(const iterator &it) const {
+			return i != it.i;
+		}
+		Entry &operator*() const {
+			return map->entries[i];
+		}
+		Entry *operator->() const {
+			return map->entries + i;
+		}
+	};
+
+	iterator begin() const {
+		iterator it;
+		it.map = this;
+		it.i = 0;
+		it.skip();
+		return it;
+	}
+	iterator end() const {
+		iterator it;
+		it.map = this;
+		it.i = _capacity;
+		return it;
+	}
+};
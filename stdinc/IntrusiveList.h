@@ -0,0 +1,132 @@
+/*
+ * IntrusiveList
+ *
+ * 要素自身が持つ ListHook でつなぐ双方向リスト．ノードを確保しないので，入れるのも外すのも O(1) で確保も失敗もしない．
+ * 要素は同時に1つのリストにしか入れられない (別のリストにも入れるなら ListHook をもう1つ持たせる)．
+ * 0 で埋めた状態が空のリストなので，static のまま (コンストラクタを呼ばずに) 使える．
+ */
+
+#pragma once
+
+template <typename T>
+struct ListHook {
+	T *prev = nullptr, *next = nullptr;
+};
+
+template <typename T, ListHook<T> T::*Hook>
+class IntrusiveList {
+private:
+	T *first = nullptr, *last = nullptr;
+	int _size = 0;
+
+	static ListHook<T> &hook(const T &x) {
+		return const_cast<T &>(x).*Hook;
+	}
+
+public:
+	constexpr IntrusiveList() = default;
+	IntrusiveList(const IntrusiveList &) = delete;
+	IntrusiveList &operator=(const IntrusiveList &) = delete;
+
+	int size() const {
+		return _size;
+	}
+	bool empty() const {
+		return !_size;
+	}
+	// 空なら nullptr
+	T *front() const {
+		return first;
+	}
+	T *back() const {
+		return last;
+	}
+	// 前後の要素 (端なら nullptr)
+	static T *next(const T &x) {
+		return hook(x).next;
+	}
+	static T *prev(const T &x) {
+		return hook(x).prev;
+	}
+
+	// pos の前に入れる (pos が nullptr なら最後に)
+	void insert(T *pos, T &x) {
+		ListHook<T> &h = hook(x);
+		h.next = pos;
+		h.prev = pos ? hook(*pos).prev : last;
+		if (h.prev) {
+			hook(*h.prev).next = &x;
+		} else {
+			first = &x;
+		}
+		if (pos) {
+			hook(*pos).prev = &x;
+		} else {
+			last = &x;
+		}
+		++_size;
+	}
+	void push_front(T &x) {
+		insert(first, x);
+	}
+	void push_back(T &x) {
+		insert(nullptr, x);
+	}
+
+	// このリストに入っている x を外す
+	void remove(T &x) {
+		ListHook<T> &h = hook(x);
+		if (h.prev) {
+			hook(*h.prev).next = h.next;
+		} else {
+			first = h.next;
+		}
+		if (h.next) {
+			hook(*h.next).prev = h.prev;
+		} else {
+			last = h.prev;
+		}
+		h.prev = h.next = nullptr;
+		--_size;
+	}
+	T *pop_front() {
+		T *x = first;
+		if (x) remove(*x);
+		return x;
+	}
+
+	struct iterator {
+	private:
+		T *node;
+
+	public:
+		friend class IntrusiveList;
+		iterator &operator++() {
+			node = hook(*node).next;
+			return *this;
+		}
+		bool operator==(const iterator &it) const {
+			return node == it.node;
+		}
+		bool operator!=(const iterator &it) const {
+			return node != it.node;
+		}
+		T &operator*() const {
+			return *node;
+		}
+		T *operator->() const {
+			return node;
+		}
+	};
+
+	iterator begin() const {
+		iterator it;
+		it.node = first;
+		return it;
+	}
+	iterator end() const {
+		iterator it;
+		it.node = nullptr;
+		return it;
+	}
+};
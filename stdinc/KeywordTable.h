@@ -0,0 +1,132 @@
+/*
+ * KeywordTable
+ *
+ * 決まったキーワードの集まりから，コンパイル時に完全ハッシュ表を作る．
+ * キーワードのハッシュ値でバケツを選び，バケツごとに衝突しなくなるずらし量を探しておく (hash and displace)．
+ * 引くときはハッシュを1回計算して，行き先の1つと比べるだけ．
+ *
+ *   constexpr const char *kWords[] = { "foo", "bar" };
+ *   constexpr KeywordTable<2> kTable(kWords);
+ *   static_assert(kTable.ok(), "...");
+ *   kTable.find("bar") // 1 (無ければ -1)
+ *
+ * constexpr の変数に置けば .rodata に入り，実行時の初期化は要らない．
+ */
+
+#pragma once
+
+#include <StringView.h>
+
+template <int N>
+class KeywordTable {
+private:
+	static constexpr int roundUp(int n) {
+		int m = 1;
+		while (m < n) m <<= 1;
+		return m;
+	}
+
+	static constexpr int kSlots = roundUp(N * 2);               // 半分まで埋める
+	static constexpr int kBuckets = roundUp(N / 2 > 0 ? N / 2 : 1); // 平均2個ずつ
+
+	unsigned short displacements[kBuckets] = {};
+	const char *keys[kSlots] = {};
+	unsigned char lengths[kSlots] = {};
+	short indices[kSlots] = {};
+	bool _ok = true;
+
+	static constexpr unsigned int lengthOf(const char *s) {
+		unsigned int n = 0;
+		while (s[n]) ++n;
+		return n;
+	}
+	// FNV-1a
+	static constexpr unsigned int hashOf(const char *s, unsigned int len) {
+		unsigned int h = 2166136261u;
+		for (unsigned int i = 0; i < len; ++i) {
+			h = (h ^ (unsigned char)s[i]) * 16777619u;
+		}
+		return h;
+	}
+	static constexpr int bucketOf(unsigned int h) {
+		return h & (kBuckets - 1);
+	}
+	// ずらした後は上のビットまで全部混ぜる (下のビットだけ同じハッシュ値が，どうずらしても同じ場所に来ないように)
+	static constexpr int slotOf(unsigned int h, unsigned int d) {
+		h ^= d * 0x9e3779b9u;
+		h = (h ^ h >> 16) * 0x85ebca6bu;
+		h = (h ^ h >> 13) * 0xc2b2ae35u;
+		return (h ^ h >> 16) & (kSlots - 1);
+	}
+
+public:
+	constexpr explicit KeywordTable(const char *const (&words)[N]) {
+		unsigned int hashes[N] = {};
+		int counts[kBuckets] = {};
+		int starts[kBuckets] = {}; // バケツ b のキーワードは members[starts[b]] から counts[b] 個
+		int members[N] = {};
+		int marks[kSlots] = {}; // 試しに入れた印 (試した回数 + 1)
+		int maxCount = 0, tries = 0;
+		for (int i = 0; i < N; ++i) {
+			hashes[i] = hashOf(words[i], lengthOf(words[i]));
+			int c = ++counts[bucketOf(hashes[i])];
+			if (c > maxCount) maxCount = c;
+		}
+		for (int b = 1; b < kBuckets; ++b) {
+			starts[b] = starts[b - 1] + counts[b - 1];
+		}
+		{
+			int filled[kBuckets] = {};
+			for (int i = 0; i < N; ++i) {
+				int b = bucketOf(hashes[i]);
+				members[starts[b] + filled[b]++] = i;
+			}
+		}
+
+		// 大きいバケツから，全部が空いている場所に入るずらし量を探す
+		for (int count = maxCount; count > 0; --count) {
+			for (int b = 0; b < kBuckets; ++b) {
+				if (counts[b] != count) continue;
+				for (unsigned int d = 0;; ++d) {
+					if (d > 0xffff) { // 同じハッシュ値のキーワードがある
+						_ok = false;
+						return;
+					}
+					bool fits = true;
+					++tries;
+					for (int k = starts[b]; k < starts[b] + count && fits; ++k) {
+						int s = slotOf(hashes[members[k]], d);
+						if (keys[s] || marks[s] == tries) fits = false;
+						marks[s] = tries;
+					}
+					if (!fits) continue;
+					displacements[b] = d;
+					for (int k = starts[b]; k < starts[b] + count; ++k) {
+						int i = members[k];
+						int s = slotOf(hashes[i], d);
+						keys[s] = words[i];
+						lengths[s] = lengthOf(words[i]);
+						indices[s] = i;
+					}
+					break;
+				}
+			}
+		}
+	}
+
+	// 全部のキーワードが衝突せずに入ったか
+	constexpr bool ok() const {
+		return _ok;
+	}
+
+	// 作ったときの words の中での位置 (無ければ -1．定数の表ならコンパイル時にも引ける)
+	constexpr int find(string_view word) const {
+		unsigned int h = hashOf(word.data(), word.length());
+		int s = slotOf(h, displacements[bucketOf(h)]);
+		if (!keys[s] || lengths[s] != word.length()) return -1;
+		for (unsigned int i = 0; i < word.length(); ++i) {
+			if (keys[s][i] != word[i]) return -1;
+		}
+		return indices[s];
+	}
+};
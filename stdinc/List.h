@@ -1,5 +1,8 @@
 #pragma once
 
+#include <ObjectPool.h>
+#include <Utility.h>
+
 template <typename T>
 class List {
 protected:
@@ -10,9 +13,44 @@ protected:
 		Node *prev = nullptr, *next = nullptr;
 		
 		Node() = default;
-		explicit Node(T newData, Node *p = nullptr, Node *n = nullptr) : data(newData), prev(p), next(n) {}
+		explicit Node(const T &newData, Node *p = nullptr, Node *n = nullptr) : data(newData), prev(p), next(n) {}
+		explicit Node(T &&newData, Node *p = nullptr, Node *n = nullptr) : data(move(newData)), prev(p), next(n) {}
+		
+		static ObjectPool<Node> pool;
+		static void *operator new(long unsigned int) { return pool.alloc(); }
+		static void operator delete(void *p) { pool.free(p); }
 	} *dummy, *head, *tail;
 	
+	// 作ったノードを先頭につなぐ
+	void linkFront(Node *node) {
+		if (tail == dummy) {
+			// 空なら
+			tail = node;
+		}
+		
+		head->prev = node;
+		head = node;
+		
+		++_length;
+	}
+	
+	// 作ったノードを最後につなぐ
+	void linkBack(Node *node) {
+		if (head == dummy) {
+			// 空なら
+			head = node;
+			node->prev = nullptr;
+		} else {
+			// 空じゃなかったら
+			tail->next = node;
+		}
+		
+		tail = node;
+		dummy->prev = node;
+		
+		++_length;
+	}
+	
 public:
 	const int &length = _length;
 
@@ -122,36 +160,20 @@ public:
 	
 	void push_front(const T &data) {
 		// 先頭に入るべきノードを作成
-		Node *node = new Node(data, nullptr, head);
-		
-		if (tail == dummy) {
-			// 空なら
-			tail = node;
-		}
-		
-		head->prev = node;
-		head = node;
-		
-		++_length;
+		linkFront(new Node(data, nullptr, head));
+	}
+	
+	void push_front(T &&data) {
+		linkFront(new Node(move(data), nullptr, head));
 	}
 	
 	void push_back(const T &data) {
 		// 最後に入るべきノードを作成
-		Node *node = new Node(data, tail, dummy);
-		
-		if (head == dummy) {
-			// 空なら
-			head = node;
-			node->prev = nullptr;
-		} else {
-			// 空じゃなかったら
-			tail->next = node;
-		}
-		
-		tail = node;
-		dummy->prev = node;
-		
-		++_length;
+		linkBack(new Node(data, tail, dummy));
+	}
+	
+	void push_back(T &&data) {
+		linkBack(new Node(move(data), tail, dummy));
 	}
 	
 	void pop_front() {
@@ -301,3 +323,6 @@ public:
 		return it;
 	}
 };
+
+template <typename T>
+ObjectPool<typename List<T>::Node> List<T>::Node::pool;
@@ -0,0 +1,83 @@
+/*
+ * オブジェクトプール
+ *
+ * 同じ型のオブジェクトを 4KB ページから切り出し，解放されたものは型ごとの free list で使い回す．
+ * 使う型は static な ObjectPool<T> pool を持ち，operator new / delete をそこに向ける．
+ * ページは operator new と同じく今のタスクの Arena からもらうので，タブを閉じればそのタブで作ったオブジェクトのページも返る．
+ * 静的コンストラクタは呼ばれないので，プールは constexpr で初期化できるようにしておく (中身は kernel/memory.cpp)
+ */
+
+#pragma once
+
+// T の型名 (gcc の __PRETTY_FUNCTION__ の "[with T = ...]" の部分を切り出す)
+template <typename T>
+struct TypeName {
+	static constexpr const char *full() {
+		return __PRETTY_FUNCTION__;
+	}
+	static constexpr int begin() {
+		const char *s = full();
+		int i = 0;
+		while (!(s[i] == 'T' && s[i + 1] == ' ' && s[i + 2] == '=' && s[i + 3] == ' ')) ++i;
+		return i + 4;
+	}
+	// 最後の ']' の位置
+	static constexpr int end() {
+		const char *s = full();
+		int i = begin(), last = i;
+		for (; s[i]; ++i) {
+			if (s[i] == ']') last = i;
+		}
+		return last;
+	}
+	struct Chars {
+		char str[end() - begin() + 1];
+	};
+	static constexpr Chars make() {
+		Chars chars = {};
+		for (int i = begin(); i < end(); ++i) {
+			chars.str[i - begin()] = full()[i];
+		}
+		return chars;
+	}
+	static constexpr Chars chars = make();
+};
+template <typename T>
+constexpr typename TypeName<T>::Chars TypeName<T>::chars;
+
+struct Arena;
+struct SlabPage;
+
+class PoolAllocator {
+private:
+	int id = -1; // Arena の中でこのプールのページを探す番号 (初めて使ったときに振る)
+
+	SlabPage *newPage(Arena *arena);
+	void freePage(SlabPage *page);
+
+public:
+	const char *const name;
+	const unsigned int size;  // オブジェクトサイズ
+	unsigned int pages = 0;   // 確保しているページ数
+	unsigned int inuse = 0;   // 使用中のオブジェクト数
+	unsigned int peak = 0;    // inuse の最大
+	unsigned int allocs = 0;  // alloc 回数
+	unsigned int frees = 0;   // free 回数
+	PoolAllocator *next = nullptr; // 一度でも使ったプールのリスト
+
+	constexpr PoolAllocator(const char *name_, unsigned int size_) : name(name_), size(size_) {}
+	void *alloc();
+	void free(void *obj);
+	unsigned int shrink();
+};
+
+template <typename T>
+class ObjectPool : public PoolAllocator {
+public:
+	// free list のポインタが入るように，4 バイト単位に揃える
+	constexpr explicit ObjectPool(const char *name_) : PoolAllocator(name_, sizeof(T) < sizeof(void *) ? sizeof(void *) : (sizeof(T) + 3) & ~3) {}
+	// テンプレートの中のプール用 (型ごとに別の名前になるように，型名を名前にする)
+	constexpr ObjectPool() : ObjectPool(TypeName<T>::chars.str) {}
+};
+
+PoolAllocator *PoolList();
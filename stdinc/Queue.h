@@ -5,6 +5,7 @@
 #pragma once
 
 #include "../kernel/memory.h"
+#include <Utility.h>
 
 template <typename T>
 class Queue {
@@ -25,8 +26,16 @@ public:
 		tail = (tail + 1) % size;
 		return true;
 	}
+	bool push(T &&data) {
+		if ((tail + 1) % size == head) { // queue is full
+			return false;
+		}
+		buf[tail] = move(data);
+		tail = (tail + 1) % size;
+		return true;
+	}
 	T pop() {
-		T data = buf[head];
+		T data = move(buf[head]); // 中身を持っていく (shared_ptr なら参照がキューに残らない)
 		head = (head + 1) % size;
 		return data;
 	}
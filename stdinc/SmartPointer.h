@@ -1,5 +1,8 @@
 #pragma once
 
+#include <ObjectPool.h>
+#include <Utility.h>
+
 class ReferenceCounter {
 private:
 	int count = 0;
@@ -8,6 +11,12 @@ public:
 	void Add();
 	int Release();
 	int Count();
+	
+	void (*dispose)(ReferenceCounter *) = nullptr; // make_shared で作ったものはオブジェクトごと消す
+	
+	static ObjectPool<ReferenceCounter> pool;
+	static void *operator new(long unsigned int) { return pool.alloc(); }
+	static void operator delete(void *p) { pool.free(p); }
 };
 
 template <typename T>
@@ -16,14 +25,21 @@ private:
 	T *pointer;
 
 private:
+	unique_ptr(const unique_ptr<T> &) = delete;
 	void operator =(const unique_ptr<T> &) = delete;
 
 public:
 	unique_ptr(T *p = nullptr) : pointer(p) {}
+	unique_ptr(unique_ptr<T> &&p) : pointer(p.release()) {}
 	virtual ~unique_ptr() {
 		delete pointer;
 	}
 	
+	unique_ptr<T> &operator =(unique_ptr<T> &&p) {
+		reset(p.release());
+		return *this;
+	}
+	
 	T *get() const {
 		return pointer;
 	}
@@ -55,67 +71,119 @@ public:
 	}
 };
 
+// make_shared 用: 参照カウントとオブジェクトを1回の確保で並べて置く
+template <typename T>
+class SharedBlock : public ReferenceCounter {
+public:
+	T object;
+	
+	template <typename ...Args>
+	explicit SharedBlock(Args &&...args) : object(forward<Args>(args)...) {
+		dispose = &destroy;
+	}
+	static void destroy(ReferenceCounter *reference) {
+		delete static_cast<SharedBlock<T> *>(reference);
+	}
+	
+	static ObjectPool<SharedBlock<T>> pool;
+	static void *operator new(long unsigned int) { return pool.alloc(); }
+	static void operator delete(void *p) { pool.free(p); }
+};
+
+template <typename T>
+ObjectPool<SharedBlock<T>> SharedBlock<T>::pool;
+
 template <typename T>
 class shared_ptr {
 private:
 	T *pointer;
 	ReferenceCounter *reference;
 	
-public:
-	shared_ptr(T *p = nullptr) : pointer(p) {
-		reference = new ReferenceCounter();
+	// make_shared から (reference は確保したばかりで誰も持っていない)
+	shared_ptr(T *p, ReferenceCounter *rc) : pointer(p), reference(rc) {
 		reference->Add();
 	}
-	shared_ptr(const shared_ptr<T> &p) {
-		if (p.reference) {
-			pointer = p.pointer;
-			reference = p.reference;
+	// 参照を1つ手放し，最後なら中身を消す
+	void drop() {
+		if (reference && reference->Release() == 0) {
+			if (reference->dispose) {
+				reference->dispose(reference);
+			} else {
+				delete pointer;
+				delete reference;
+			}
+		}
+	}
+	
+public:
+	template <typename U, typename ...Args>
+	friend shared_ptr<U> make_shared(Args &&...args);
+	
+	// nullptr なら参照カウントも確保しない
+	shared_ptr(T *p = nullptr) : pointer(p), reference(nullptr) {
+		if (p) {
+			reference = new ReferenceCounter();
 			reference->Add();
 		}
 	}
+	shared_ptr(const shared_ptr<T> &p) : pointer(p.pointer), reference(p.reference) {
+		if (reference) reference->Add();
+	}
+	// 参照カウントを触らずに持っていく (p は空になる)
+	shared_ptr(shared_ptr<T> &&p) : pointer(p.pointer), reference(p.reference) {
+		p.pointer = nullptr;
+		p.reference = nullptr;
+	}
+	shared_ptr(unique_ptr<T> &&p) : shared_ptr(p.release()) {}
 	virtual ~shared_ptr() {
-		if (reference && reference->Release() == 0) {
-			delete pointer;
-			delete reference;
-		}
+		drop();
 	}
 	
 	T *get() const {
 		return pointer;
 	}
 	void reset(T *p) {
-		if (reference && reference->Release() == 0) {
-			delete pointer;
-			delete reference;
-		}
+		drop();
 		
 		pointer = p;
-		reference = new ReferenceCounter();
-		reference->Add();
+		reference = nullptr;
+		if (p) {
+			reference = new ReferenceCounter();
+			reference->Add();
+		}
 	}
 	ReferenceCounter *getRC() const {
 		return reference;
 	}
 	int use_count() const {
-		return reference->Count();
+		return reference ? reference->Count() : 0;
 	}
 	bool unique() const {
-		return reference->Count() == 1;
+		return use_count() == 1;
 	}
 	
 	shared_ptr<T> &operator =(const shared_ptr<T> &p) {
 		if (this != &p) {
-			if (reference && reference->Release() == 0) {
-				delete pointer;
-				delete reference;
-			}
+			drop();
 			
 			pointer = p.pointer;
 			reference = p.reference;
-			reference->Add();
+			if (reference) reference->Add();
 		}
 		return *this;
 	}
+	shared_ptr<T> &operator =(shared_ptr<T> &&p) {
+		// 先に p を空にしておけば自分自身を渡されても壊れない
+		T *newPointer = p.pointer;
+		ReferenceCounter *newReference = p.reference;
+		p.pointer = nullptr;
+		p.reference = nullptr;
+		drop();
+		
+		pointer = newPointer;
+		reference = newReference;
+		return *this;
+	}
 	T *operator ->() const {
 		return pointer;
 	}
@@ -132,3 +200,94 @@ public:
 		return pointer != nullptr;
 	}
 };
+
+// 参照カウントとオブジェクトをまとめて確保する
+template <typename T, typename ...Args>
+shared_ptr<T> make_shared(Args &&...args) {
+	SharedBlock<T> *block = new SharedBlock<T>(forward<Args>(args)...);
+	return shared_ptr<T>(&block->object, block);
+}
+
+// intrusive_ptr で指す型の基底 (参照カウントをオブジェクトの中に持つので別の確保がいらない)
+class RefCounted {
+private:
+	int refCount = 0;
+	
+public:
+	RefCounted() = default;
+	RefCounted(const RefCounted &) {} // コピーしたオブジェクトは誰からも指されていない
+	RefCounted &operator =(const RefCounted &) {
+		return *this;
+	}
+	
+	void AddRef() {
+		++refCount;
+	}
+	int ReleaseRef() {
+		return --refCount;
+	}
+	int RefCount() const {
+		return refCount;
+	}
+};
+
+template <typename T>
+class intrusive_ptr {
+private:
+	T *pointer;
+	
+public:
+	intrusive_ptr(T *p = nullptr) : pointer(p) {
+		if (pointer) pointer->AddRef();
+	}
+	intrusive_ptr(const intrusive_ptr<T> &p) : pointer(p.pointer) {
+		if (pointer) pointer->AddRef();
+	}
+	intrusive_ptr(intrusive_ptr<T> &&p) : pointer(p.pointer) {
+		p.pointer = nullptr;
+	}
+	// 派生クラスへのポインタから
+	template <typename U>
+	intrusive_ptr(const intrusive_ptr<U> &p) : pointer(p.get()) {
+		if (pointer) pointer->AddRef();
+	}
+	~intrusive_ptr() {
+		if (pointer && pointer->ReleaseRef() == 0) delete pointer;
+	}
+	
+	T *get() const {
+		return pointer;
+	}
+	void reset(T *p = nullptr) {
+		intrusive_ptr<T>(p).swap(*this);
+	}
+	void swap(intrusive_ptr<T> &p) {
+		T *tmp = pointer;
+		pointer = p.pointer;
+		p.pointer = tmp;
+	}
+	int use_count() const {
+		return pointer ? pointer->RefCount() : 0;
+	}
+	
+	intrusive_ptr<T> &operator =(const intrusive_ptr<T> &p) {
+		intrusive_ptr<T>(p).swap(*this);
+		return *this;
+	}
+	intrusive_ptr<T> &operator =(intrusive_ptr<T> &&p) {
+		intrusive_ptr<T>(move(p)).swap(*this);
+		return *this;
+	}
+	T *operator ->() const {
+		return pointer;
+	}
+	T &operator *() const {
+		return *pointer;
+	}
+	operator T*() const { // cast
+		return pointer;
+	}
+	operator bool() const {
+		return pointer != nullptr;
+	}
+};
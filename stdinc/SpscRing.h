@@ -0,0 +1,80 @@
+/*
+ * SpscRing
+ *
+ * 書き込む側と読む側が1つずつのリングバッファ．
+ * 大きさは 2 の累乗に切り上げて，位置は % の代わりにマスクで求める (head と tail は回しっぱなしにする)．
+ * head は読む側，tail は書き込む側しか書き換えないので，ロックも割り込み禁止も要らない．
+ * 中身を書いてから tail を進め (release)，tail を読んでから中身を読む (acquire) ので，読む側が書きかけの要素を見ることはない．
+ * 書き込む側が複数あるときは，呼ぶ側で Cli するなどして1つずつ書き込むこと．
+ */
+
+#pragma once
+
+#include <Utility.h>
+
+template <typename T>
+class SpscRing {
+private:
+	T *buf;
+	unsigned int mask;
+	unsigned int head = 0; // 次に読む位置 (読む側だけが書き換える)
+	unsigned int tail = 0; // 次に書く位置 (書き込む側だけが書き換える)
+
+	static unsigned int roundUp(unsigned int size) {
+		unsigned int n = 1;
+		while (n < size) n <<= 1;
+		return n;
+	}
+
+public:
+	explicit SpscRing(unsigned int size) : buf(new T[roundUp(size)]), mask(roundUp(size) - 1) {}
+	~SpscRing() {
+		delete[] buf;
+	}
+	SpscRing(const SpscRing &) = delete;
+	SpscRing &operator=(const SpscRing &) = delete;
+
+	// 書き込む側
+	bool push(const T &data) {
+		unsigned int t = tail;
+		if (t - __atomic_load_n(&head, __ATOMIC_ACQUIRE) > mask) { // ring is full
+			return false;
+		}
+		buf[t & mask] = data;
+		__atomic_store_n(&tail, t + 1, __ATOMIC_RELEASE);
+		return true;
+	}
+
+	// 読む側 (空なら false)
+	bool pop(T &data) {
+		unsigned int h = head;
+		if (h == __atomic_load_n(&tail, __ATOMIC_ACQUIRE)) {
+			return false;
+		}
+		data = move(buf[h & mask]);
+		__atomic_store_n(&head, h + 1, __ATOMIC_RELEASE);
+		return true;
+	}
+
+	// 溜まっているものを最大 n 個まとめて取り出す (取り出した数を返す)
+	int pop_n(T *out, int n) {
+		unsigned int h = head;
+		unsigned int count = __atomic_load_n(&tail, __ATOMIC_ACQUIRE) - h;
+		if ((unsigned int)n > count) n = count;
+		for (int i = 0; i < n; ++i) {
+			out[i] = move(buf[(h + i) & mask]);
+		}
+		__atomic_store_n(&head, h + n, __ATOMIC_RELEASE);
+		return n;
+	}
+
+	bool empty() const {
+		return __atomic_load_n(&head, __ATOMIC_ACQUIRE) == __atomic_load_n(&tail, __ATOMIC_ACQUIRE);
+	}
+	unsigned int size() const {
+		return __atomic_load_n(&tail, __ATOMIC_ACQUIRE) - __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+	}
+	unsigned int capacity() const {
+		return mask + 1;
+	}
+};
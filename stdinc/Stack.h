@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <Utility.h>
+
 template <typename T>
 class Stack {
 protected:
@@ -22,8 +24,15 @@ public:
 		buf[tail++] = data;
 		return true;
 	}
+	bool push(T &&data) {
+		if (tail == size) { // stack is full
+			return false;
+		}
+		buf[tail++] = move(data);
+		return true;
+	}
 	T pop() {
-		return buf[--tail];
+		return move(buf[--tail]);
 	}
 	T &top() {
 		return buf[tail - 1];
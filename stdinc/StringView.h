@@ -0,0 +1,81 @@
+/*
+ * string_view
+ *
+ * 他の文字列 (ファイルのバッファなど) の一部を指すだけの文字列．コピーも確保もしない．
+ * 指している文字列より長く使わないこと．
+ */
+
+#pragma once
+
+struct string;
+
+class string_view {
+private:
+	const char *_data = nullptr;
+	unsigned _length = 0;
+
+	static constexpr unsigned lengthOf(const char *str) {
+		unsigned n = 0;
+		while (str[n]) ++n;
+		return n;
+	}
+	static char lower(char c) {
+		return ('A' <= c && c <= 'Z') ? c + ('a' - 'A') : c;
+	}
+
+public:
+	constexpr string_view() = default;
+	constexpr string_view(const char *str) : _data(str), _length(lengthOf(str)) {}
+	constexpr string_view(const char *str, unsigned len) : _data(str), _length(len) {}
+	string_view(const string &str); // 中身は pistring.h
+
+	constexpr const char *data() const { return _data; }
+	constexpr unsigned length() const { return _length; }
+	bool empty() const { return !_length; }
+	const char *begin() const { return _data; }
+	const char *end() const { return _data + _length; }
+	constexpr char operator[](unsigned x) const { return _data[x]; }
+
+	// pos から最大 len 文字
+	string_view substr(unsigned pos, unsigned len = ~0u) const {
+		if (pos > _length) pos = _length;
+		if (len > _length - pos) len = _length - pos;
+		return string_view(_data + pos, len);
+	}
+
+	int compare(string_view str) const {
+		unsigned n = _length < str._length ? _length : str._length;
+		for (unsigned i = 0; i < n; ++i) {
+			if (_data[i] != str._data[i]) return (unsigned char)_data[i] - (unsigned char)str._data[i];
+		}
+		return (int)_length - (int)str._length;
+	}
+
+	// pos からの n 文字が s の先頭 n 文字と同じなら 0 (string::compare と同じ使い方)
+	int compare(unsigned pos, unsigned n, const char *s) const {
+		for (unsigned i = 0; i < n; ++i) {
+			char c = pos + i < _length ? _data[pos + i] : 0;
+			if (c != s[i]) return (unsigned char)c - (unsigned char)s[i];
+			if (!c) break;
+		}
+		return 0;
+	}
+
+	// 大文字小文字を区別しない compare
+	int comparei(unsigned pos, unsigned n, const char *s) const {
+		for (unsigned i = 0; i < n; ++i) {
+			char c = lower(pos + i < _length ? _data[pos + i] : 0), d = lower(s[i]);
+			if (c != d) return (unsigned char)c - (unsigned char)d;
+			if (!c) break;
+		}
+		return 0;
+	}
+};
+
+inline bool operator==(string_view str1, string_view str2) {
+	return str1.length() == str2.length() && str1.compare(str2) == 0;
+}
+
+inline bool operator!=(string_view str1, string_view str2) {
+	return !(str1 == str2);
+}
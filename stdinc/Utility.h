@@ -0,0 +1,27 @@
+#pragma once
+
+// 参照を外した型
+template <typename T> struct remove_reference { typedef T type; };
+template <typename T> struct remove_reference<T &> { typedef T type; };
+template <typename T> struct remove_reference<T &&> { typedef T type; };
+
+// 右辺値にして中身を持っていってもらう (std::move 相当)
+template <typename T>
+constexpr typename remove_reference<T>::type &&move(T &&t) noexcept {
+	return static_cast<typename remove_reference<T>::type &&>(t);
+}
+
+// 受け取ったときの値カテゴリのまま渡す (std::forward 相当)
+template <typename T>
+constexpr T &&forward(typename remove_reference<T>::type &t) noexcept {
+	return static_cast<T &&>(t);
+}
+template <typename T>
+constexpr T &&forward(typename remove_reference<T>::type &&t) noexcept {
+	return static_cast<T &&>(t);
+}
+
+// 確保済みの場所にオブジェクトを作る (placement new)
+inline void *operator new(long unsigned int, void *p) noexcept {
+	return p;
+}
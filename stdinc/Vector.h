@@ -0,0 +1,176 @@
+/*
+ * Vector
+ *
+ * 要素を1つの配列に並べて持つ可変長配列．足りなくなったら倍の大きさに確保し直す．
+ * 確保し直すと要素の場所が変わるので，要素へのポインタやイテレータを持ち続けないこと．
+ */
+
+#pragma once
+
+#include <Utility.h>
+
+template <typename T>
+class Vector {
+private:
+	T *buf = nullptr;
+	int _size = 0, _capacity = 0;
+	
+	static T *allocate(int n) {
+		return static_cast<T *>(operator new(n * sizeof(T)));
+	}
+	
+	// 中身を newCapacity の配列に移す
+	void reallocate(int newCapacity) {
+		T *newBuf = allocate(newCapacity);
+		for (int i = 0; i < _size; ++i) {
+			new (newBuf + i) T(move(buf[i]));
+			buf[i].~T();
+		}
+		operator delete(buf);
+		buf = newBuf;
+		_capacity = newCapacity;
+	}
+	
+	// あと1つ入るようにする
+	void grow() {
+		if (_size == _capacity) {
+			reallocate(_capacity ? _capacity * 2 : 4);
+		}
+	}
+
+public:
+	typedef T *iterator;
+	typedef const T *const_iterator;
+	
+	Vector() = default;
+	Vector(const Vector &v) {
+		reserve(v._size);
+		for (int i = 0; i < v._size; ++i) {
+			new (buf + i) T(v.buf[i]);
+		}
+		_size = v._size;
+	}
+	Vector(Vector &&v) : buf(v.buf), _size(v._size), _capacity(v._capacity) {
+		v.buf = nullptr;
+		v._size = v._capacity = 0;
+	}
+	~Vector() {
+		clear();
+		operator delete(buf);
+	}
+	Vector &operator=(const Vector &v) {
+		if (buf != v.buf) {
+			clear();
+			reserve(v._size);
+			for (int i = 0; i < v._size; ++i) {
+				new (buf + i) T(v.buf[i]);
+			}
+			_size = v._size;
+		}
+		return *this;
+	}
+	Vector &operator=(Vector &&v) {
+		if (buf != v.buf) {
+			clear();
+			operator delete(buf);
+			buf = v.buf;
+			_size = v._size;
+			_capacity = v._capacity;
+			v.buf = nullptr;
+			v._size = v._capacity = 0;
+		}
+		return *this;
+	}
+	
+	int size() const {
+		return _size;
+	}
+	int capacity() const {
+		return _capacity;
+	}
+	bool empty() const {
+		return !_size;
+	}
+	
+	// n 個まで確保し直さずに入るようにする
+	void reserve(int n) {
+		if (n > _capacity) reallocate(n);
+	}
+	
+	T &operator[](int i) {
+		return buf[i];
+	}
+	const T &operator[](int i) const {
+		return buf[i];
+	}
+	T &front() {
+		return buf[0];
+	}
+	T &back() {
+		return buf[_size - 1];
+	}
+	
+	void push_back(const T &data) {
+		if (_size == _capacity) {
+			// data が自分の要素かもしれないので，移す前にコピーしておく
+			T copy(data);
+			grow();
+			new (buf + _size) T(move(copy));
+		} else {
+			new (buf + _size) T(data);
+		}
+		++_size;
+	}
+	void push_back(T &&data) {
+		grow();
+		new (buf + _size) T(move(data));
+		++_size;
+	}
+	template <typename ...Args>
+	T &emplace_back(Args &&...args) {
+		grow();
+		new (buf + _size) T(forward<Args>(args)...);
+		return buf[_size++];
+	}
+	void pop_back() {
+		if (!_size) return;
+		buf[--_size].~T();
+	}
+	
+	// pos を消して後ろを詰める (消した次の要素を返す)
+	iterator erase(iterator pos) {
+		for (iterator it = pos; it + 1 != end(); ++it) {
+			*it = move(*(it + 1));
+		}
+		pop_back();
+		return pos;
+	}
+	
+	// data と等しい要素を全部消す
+	void remove(const T &data) {
+		int n = 0;
+		for (int i = 0; i < _size; ++i) {
+			if (buf[i] == data) continue;
+			if (n != i) buf[n] = move(buf[i]);
+			++n;
+		}
+		while (_size > n) pop_back();
+	}
+	
+	void clear() {
+		while (_size) pop_back();
+	}
+	
+	iterator begin() {
+		return buf;
+	}
+	iterator end() {
+		return buf + _size;
+	}
+	const_iterator begin() const {
+		return buf;
+	}
+	const_iterator end() const {
+		return buf + _size;
+	}
+};
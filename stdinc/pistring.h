@@ -20,8 +20,10 @@ Member Functions:
 	rfind(const char c,unsigned n,unsigned start) - returns the position of the nth occurrence of c going backwards starting at start
 	rfind(const char* str,unsigned n,unsigned start) - returns the position of the nth occurrence of str going backwards starting at start
 	rfind(const string& str,unsigned n,unsigned start) - returns the position of the nth occurrence of str going backwards starting at start
+	extend(unsigned n) - lengthen the string by n characters and return a pointer to them (the caller fills them in)
 	reserve(unsigned newsize) - request a new maximum size for the string (returns new size)
 		NOTE: If newsize is less than the current size, the reallocation will NOT happen
+	NOTE: strings shorter than localsize are kept in an inline buffer and don't allocate
 	upper() - make all letters in the string uppercase (no return)
 	lower() - make all letters in the string lowercase (no return)
 	length() - returns the length of the string
@@ -38,6 +40,7 @@ Member Operators:
 	string& operator=(const char c) - sets the string equal to c (nullptr terminated) (returns the string)
 	string& operator=(const char* str) - sets the string equal to str (returns the string)
 	string& operator=(const string& str) - sets the string equal to str (returns the string)
+	string& operator=(string&& str) - takes over the buffer of str, leaving str empty (returns the string)
 	string& operator+=(const char c) - appends c to the string (returns the string)
 	string& operator+=(const char* str) - appends str to the string (returns the string)
 	string& operator+=(cosnt string& str) - appends str to the string (returns the string)
@@ -67,6 +70,9 @@ Global Operators:
 #pragma once
 
 #include <stddef.h>
+#include <Utility.h>
+#include <StringView.h>
+#include <Format.h>
 
 extern char stroob;
 
@@ -75,11 +81,8 @@ struct string{
 	//memory related functions
 		//resize the string data array
 		void resizedata(unsigned newsize);
-		//doesn't check for memory overlapping
-		void* memcpy(void* dst,const void* src,unsigned len);
-		//does check for memory overlapping
-		void* memmove(void* dst,const void* src,unsigned len);
-		unsigned strlen(const char* str) const;
+		//point data at a buffer that can hold len characters (the inline buffer if it fits)
+		void initdata(unsigned len);
 	//functions that are called by other functions
 		//count the number of occurrences of str
 		unsigned countstr(const char* str,unsigned size) const;
@@ -98,6 +101,8 @@ struct string{
 		const static unsigned aA_diff='a'-'A';
 		//the maximum buffer size
 		const static unsigned minbuffsize=32;
+		//the size of the inline buffer (shorter strings don't touch the heap)
+		const static unsigned localsize=16;
 	//friends
 		//operators
 		//equal
@@ -128,17 +133,22 @@ struct string{
 		template <typename T> friend string to_string(T n);
 	//iterator
 		friend struct iterator;
+	//string_view
+		friend class string_view;
 	protected:
 		//data
 		char* data;
 		unsigned datasize,datalen;
+		char local[localsize];
 	public:
 		string();
 		string(const char* str);
 		string(const char *str, size_t len);
 		string(size_t n, char c);
 		string(const string& str);
+		string(string&& str);
 		string(const string& str, unsigned pos, unsigned len);
+		explicit string(string_view str) : string(str.data(), str.length()) {}
 		~string();
 		inline operator const char*() const{
 			return data;}
@@ -162,9 +172,12 @@ struct string{
 		string& operator=(const char c);
 		string& operator=(const char* str);
 		string& operator=(const string& str);
+		string& operator=(string&& str);
 		string& operator+=(const char c);
 		string& operator+=(const char* str);
 		string& operator+=(const string& str);
+		//lengthen the string by n characters and return where they start (the caller fills them in)
+		char* extend(unsigned n);
 		void clear();
 		unsigned insert(unsigned pos,unsigned n,const char c);
 		unsigned insert(unsigned pos,const char* str);
@@ -253,9 +266,12 @@ namespace strexternalfuncs{
 
 //global operators
 //add
+//(lhs is moved, so a chain like a + b + c reuses one buffer)
 template <typename T, typename U>
 string operator+ (T lhs, U rhs) {
-	return string(lhs) += rhs;
+	string str(move(lhs));
+	str += rhs;
+	return str;
 }
 
 //equal
@@ -291,21 +307,33 @@ bool operator<=(const char* str1,const string& str2);
 // number to string
 template <typename T>
 string to_string(T n) {
-	bool minus = false;
 	string tmp;
-	if (n == 0) {
-		tmp = "0";
-		return tmp;
+	format(tmp, "{}"_fmt, n);
+	return tmp;
+}
+
+// format() into a string appends to it
+template <>
+struct FormatWriter<string> {
+	string &str;
+	unsigned start;
+	explicit FormatWriter(string &str_) : str(str_), start(str_.length()) {}
+	void put(const char *s, unsigned n) {
+		char *p = str.extend(n);
+		for (unsigned i = 0; i < n; ++i) p[i] = s[i];
 	}
-	if (n < 0) {
-		minus = true;
-		n = -n;
+	void fill(char c, unsigned n) {
+		char *p = str.extend(n);
+		for (unsigned i = 0; i < n; ++i) p[i] = c;
 	}
-	while (n > 0) {
-		tmp += char(n % 10 + '0');
-		n /= 10;
+	char *claim(unsigned n) {
+		return str.extend(n);
 	}
-	if (minus) tmp += '-';
-	tmp.reverse();
-	return tmp;
-}
+	unsigned finish() {
+		return str.length() - start;
+	}
+};
+template <> struct FormatArg<string> : FormatText {};
+
+// the view is valid until the string changes
+inline string_view::string_view(const string &str) : _data(str.data), _length(str.datalen) {}
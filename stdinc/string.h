@@ -30,6 +30,7 @@ void *memmove(void *s, const void *ct, size_t n);
 int memcmp(const void *cs, const void *ct, size_t n);
 void *memchr(const void *cs, int c, size_t n);
 void *memset(void *s, int c, size_t n);
+void *memset32(void *s, unsigned int c, size_t n);
 char *strdup(const char *s);
 
 #if (defined(__cplusplus))